@@ -0,0 +1,20 @@
+#!/bin/sh
+# compare.sh - print two bench results side by side (the output of run.sh or microbench)
+# usage: bench/compare.sh <before results> <after results>
+BEFORE=$1
+AFTER=$2
+
+if [ ! -f "$BEFORE" ] || [ ! -f "$AFTER" ]
+then
+	echo "usage: bench/compare.sh <before results> <after results>"
+	exit 1
+fi
+
+printf "%-32s %10s %10s %8s\n" "" "before" "after" "speedup"
+awk 'NR == FNR { before[$1] = $2; next }
+	{
+		if ($1 in before && $2 > 0)
+			printf "%-32s %10d %10d %7.2fx  %s\n", $1, before[$1], $2, before[$1] / $2, $3
+		else
+			printf "%-32s %10s %10d %8s  %s\n", $1, "-", $2, "-", $3
+	}' "$BEFORE" "$AFTER"
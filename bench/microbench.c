@@ -0,0 +1,192 @@
+/**
+ * @file microbench.c
+ * @author guffi
+ *
+ * @brief microbenchmark of the solver hot functions in isolation - parser, copyNode and
+ * 		getNodeChildren on the root of each given puzzle. prints one line per function and puzzle
+ * 		in the bench/run.sh format, so bench/compare.sh can compare two runs.
+ * 		usage: microbench <suduku file>...
+ */
+//-------------------------------------include------------------------------------------------------
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../sudukusolve.h"
+
+//------------------------------------const definitions---------------------------------------------
+/**
+ * @def BENCH_NANO 200000000
+ * @brief the least time each function is measured, in nanoseconds
+ */
+#define BENCH_NANO 200000000L
+/**
+ * @def NANO_IN_SEC 1000000000
+ * @brief nanoseconds in one second
+ */
+#define NANO_IN_SEC 1000000000L
+/**
+ * @def MAX_NAME 64
+ * @brief max length of one result name
+ */
+#define MAX_NAME 64
+
+/**
+ * @def struct Puzzle
+ * @brief the puzzle file text, kept in memory so the parser is measured without the disk
+ */
+typedef struct Puzzle
+{
+	char* text;
+	size_t length;
+	const char* name;
+} Puzzle;
+
+//-------------------------------------------functions----------------------------------------------
+/**
+ * @def nowNano
+ * @brief monotonic time in nanoseconds
+ */
+static long nowNano(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * NANO_IN_SEC + now.tv_nsec;
+}
+
+/**
+ * @def parsePuzzle
+ * @brief parse the puzzle text
+ * @return the suduku table, NULL if it is not valid
+ */
+static Suduku* parsePuzzle(const Puzzle* puzzle)
+{
+	FILE* in = fmemopen(puzzle->text, puzzle->length, "r");
+	if(in == NULL)
+	{
+		return NULL;
+	}
+	Suduku* sudukuTable = (Suduku*)parser(in, puzzle->name, stderr);
+	fclose(in);
+	return sudukuTable;
+}
+
+/**
+ * @def benchParser
+ * @brief one parser call, the table is freed
+ */
+static void benchParser(const Puzzle* puzzle, Suduku* root)
+{
+	(void)root;
+	freeNode(parsePuzzle(puzzle));
+}
+
+/**
+ * @def benchCopyNode
+ * @brief one copyNode of the root and its free
+ */
+static void benchCopyNode(const Puzzle* puzzle, Suduku* root)
+{
+	(void)puzzle;
+	freeNode(copyNode(root));
+}
+
+/**
+ * @def benchChildren
+ * @brief one expansion of a copy of the root, as the search expands each node - the copy board is
+ * 		taken over by getNodeChildren, and the children are freed
+ */
+static void benchChildren(const Puzzle* puzzle, Suduku* root)
+{
+	(void)puzzle;
+	Suduku* node = (Suduku*)copyNode(root);
+	void** children = NULL;
+	int amount = getNodeChildren(node, &children);
+	int index;
+	for(index = 0; index < amount; index++)
+	{
+		freeNode(children[index]);
+	}
+	free(children);
+	freeNode(node);
+}
+
+/**
+ * @def measure
+ * @brief call the function until BENCH_NANO passed and print the time of one call
+ */
+static void measure(const char* function, void (*call)(const Puzzle*, Suduku*),
+					const Puzzle* puzzle, Suduku* root)
+{
+	char name[MAX_NAME];
+	long start = nowNano(), elapsed;
+	long calls = 0;
+	do
+	{
+		call(puzzle, root);
+		calls++;
+		elapsed = nowNano() - start;
+	} while(elapsed < BENCH_NANO);
+
+	snprintf(name, MAX_NAME, "%s/%s", function, puzzle->name);
+	printf("%-32s %10ld ns/call\n", name, elapsed / calls);
+}
+
+/**
+ * @def readPuzzle
+ * @brief read the whole puzzle file
+ * @return False if the file could not be read
+ */
+static int readPuzzle(const char* fileName, Puzzle* puzzle)
+{
+	puzzle->text = NULL;
+	FILE* in = fopen(fileName, "r");
+	if(in == NULL)
+	{
+		return 0;
+	}
+	fseek(in, 0, SEEK_END);
+	long length = ftell(in);
+	fseek(in, 0, SEEK_SET);
+	puzzle->text = (length > 0) ? (char*)malloc(length) : NULL;
+	puzzle->length = (puzzle->text != NULL) ? fread(puzzle->text, 1, length, in) : 0;
+	fclose(in);
+
+	const char* base = strrchr(fileName, '/');
+	puzzle->name = (base != NULL) ? base + 1 : fileName;
+	return puzzle->length > 0;
+}
+
+/**
+ * @def main
+ * @brief measure the functions on each given puzzle
+ */
+int main(int argc, char* argv[])
+{
+	Puzzle puzzle;
+	Suduku* root;
+	int index;
+
+	if(argc < 2)
+	{
+		printf("usage: microbench <suduku file>...\n");
+		return EXIT_FAILURE;
+	}
+
+	for(index = 1; index < argc; index++)
+	{
+		if(!readPuzzle(argv[index], &puzzle) || (root = parsePuzzle(&puzzle)) == NULL)
+		{
+			printf("%s: can not read the puzzle\n", argv[index]);
+			free(puzzle.text);
+			continue;
+		}
+		measure("parser", benchParser, &puzzle, root);
+		measure("copyNode", benchCopyNode, &puzzle, root);
+		measure("getNodeChildren", benchChildren, &puzzle, root);
+		freeNode(root);
+		free(puzzle.text);
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,19 @@
+#!/bin/sh
+# run.sh - time the solver on every puzzle of the bench suite
+# usage: bench/run.sh [solver] [runs]
+SOLVER=${1:-./sudukusolver}
+RUNS=${2:-5}
+DIR=$(dirname "$0")
+
+for puzzle in "$DIR"/suduku*.txt
+do
+	start=$(date +%s%N)
+	i=0
+	while [ $i -lt "$RUNS" ]
+	do
+		"$SOLVER" "$puzzle" > /dev/null
+		i=$((i + 1))
+	done
+	end=$(date +%s%N)
+	printf "%-20s %8d us/solve\n" "$(basename "$puzzle")" $(((end - start) / 1000 / RUNS))
+done
@@ -0,0 +1,45 @@
+#!/bin/sh
+# strategies.sh - solve every puzzle of the bench suite with each search strategy and check that
+# the printed table is a full valid suduku that keeps the puzzle numbers
+# at each of the given deduction levels
+# usage: bench/strategies.sh [solver] [level...]
+SOLVER=${1:-./sudukusolver}
+[ $# -gt 0 ] && shift
+LEVELS=${*:-0 1 4}
+DIR=$(dirname "$0")
+FAILED=0
+
+for level in $LEVELS
+do
+	for strategy in dfs best deepening beam
+	do
+		for puzzle in "$DIR"/suduku*.txt
+		do
+			if "$SOLVER" -s "$strategy" -l "$level" "$puzzle" 2> /dev/null | awk '
+				# the puzzle comes first, then the solver output - both start with the table size
+				NR == FNR { if (FNR > 1) for (col = 1; col <= NF; col++) given[FNR, col] = $col; next }
+				FNR == 1 { size = $1; box = int(sqrt(size) + 0.5); next }
+				{
+					if (NF != size) bad = 1
+					row = FNR - 1
+					for (col = 1; col <= NF; col++)
+					{
+						if (given[FNR, col] != 0 && given[FNR, col] != $col) bad = 1
+						if ($col < 1 || $col > size) bad = 1
+						unit = int((row - 1) / box) * box + int((col - 1) / box)
+						if (seen["r", row, $col]++ || seen["c", col, $col]++ || seen["b", unit, $col]++)
+							bad = 1
+					}
+					rows = row
+				}
+				END { exit (bad || size == 0 || rows != size) }' "$puzzle" -
+			then
+				printf "%-20s %-10s %-2s ok\n" "$(basename "$puzzle")" "$strategy" "$level"
+			else
+				printf "%-20s %-10s %-2s FAILED\n" "$(basename "$puzzle")" "$strategy" "$level"
+				FAILED=1
+			fi
+		done
+	done
+done
+exit $FAILED
@@ -8,214 +8,690 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <string.h>
 #include "genericdfs.h"
 //------------------------------------const definitions--------------------------------------------
 #define ERROR -1
-
+#define TRUE 1
+#define FALSE 0
 /**
- * @def struct Node 
- * @brief define node struct each node include - data value (pNode) and pointer to the next Node 
+ * @def NO_DEPTH_LIMIT 0
+ * @brief depth limit of unlimited dfs
  */
-typedef struct Node
-{
-	pNode _data;
-	struct Node * _next;
-} Node;
+#define NO_DEPTH_LIMIT 0
+/**
+ * @def HEAP_INITIAL_CAPACITY 64
+ * @brief the first capacity of the best first and beam heaps
+ */
+#define HEAP_INITIAL_CAPACITY 64
+/**
+ * @def STACK_INITIAL_CAPACITY 64
+ * @brief the first capacity (in entries) of the dfs stack
+ */
+#define STACK_INITIAL_CAPACITY 64
+/**
+ * @def STACK_ENTRY_ALIGN 16
+ * @brief stack entries are padded to this size so inline nodes stay aligned
+ */
+#define STACK_ENTRY_ALIGN 16
+/**
+ * @def ALIGN_UP(size, align)
+ * @brief round size up to multiple of align
+ */
+#define ALIGN_UP(size, align) (((size) + (align) - 1) / (align) * (align))
 
 /**
  * @def struct Stack
- * @brief define the stack struct
+ * @brief define the stack struct - one contiguous array of entries that grows by doubling.
+ * 		each entry is the node (nodeSize bytes inline, or its pNode when nodeSize is 0) followed
+ * 		by the node depth in the tree.
  */
 typedef struct Stack
 {
-	Node * _top;
-	size_t _elementSize;
+	char* _entries;
+	size_t _entrySize;
+	size_t _nodeSize;
+	size_t _size;
+	size_t _capacity;
 } Stack;
+
+/**
+ * @def struct HeapEntry
+ * @brief one node of the best first heap - its value and the order it was pushed in
+ */
+typedef struct HeapEntry
+{
+	pNode _data;
+	unsigned long _value;
+	size_t _order;
+} HeapEntry;
+
+/**
+ * @def struct Heap
+ * @brief binary max heap of nodes, ordered by value and then by newest order
+ */
+typedef struct Heap
+{
+	HeapEntry* _entries;
+	size_t _size;
+	size_t _capacity;
+	size_t _pushed;
+} Heap;
+
+/**
+ * @def struct SearchResult
+ * @brief the best node found until now and its value
+ */
+typedef struct SearchResult
+{
+	unsigned int _maxValue;
+	pNode _maxNode;
+} SearchResult;
 //-------------------------------------------functions---------------------------------------------
 
 /**
- * @def stackAlloc(size_t elementSize)
- * @brief alloc the stack
- * @param size_t elementSize - stack size
- * @return the stack
+ * @def stackInit
+ * @brief initialize empty stack
+ * @param stack - the stack
+ * @param nodeSize - the size of inline node, 0 to hold pNode pointers
  */
-Stack* stackAlloc(size_t elementSize)
+static void stackInit(Stack* stack, size_t nodeSize)
 {
-	Stack* stack = (Stack*)malloc(sizeof(Stack));
-	if(stack == NULL)
+	size_t payload = nodeSize ? nodeSize : sizeof(pNode);
+	stack->_entries = NULL;
+	stack->_nodeSize = nodeSize;
+	stack->_entrySize = ALIGN_UP(ALIGN_UP(payload, sizeof(unsigned int)) + sizeof(unsigned int), \
+								 STACK_ENTRY_ALIGN);
+	stack->_size = 0;
+	stack->_capacity = 0;
+}
+
+/**
+ * @def stackEntry
+ * @brief the address of the entry in the given index
+ */
+static char* stackEntry(const Stack* stack, size_t index)
+{
+	return stack->_entries + index * stack->_entrySize;
+}
+
+/**
+ * @def entryDepth
+ * @brief the address of the depth field of the given entry
+ */
+static unsigned int* entryDepth(const Stack* stack, char* entry)
+{
+	size_t payload = stack->_nodeSize ? stack->_nodeSize : sizeof(pNode);
+	return (unsigned int*)(entry + ALIGN_UP(payload, sizeof(unsigned int)));
+}
+
+/**
+ * @def releaseNode
+ * @brief free the node the search is done with - inline nodes only release what they hold,
+ * 		their bytes belong to the stack or the current node buffer
+ */
+static void releaseNode(const Stack* stack, pNode node, const SearchOptions* options, 
+						freeNodeFunc freeNode)
+{
+	if(stack->_nodeSize)
 	{
-		//allocation faild;
-		return NULL;
+		options->clearNode(node);
+	}
+	else
+	{
+		freeNode(node);
 	}
-	stack->_top = NULL;
-	stack->_elementSize = elementSize;
-	return stack;
 }
 
 /**
  * @def freeStack
- * @brief free the stack from memory
+ * @brief free the stack and the nodes left in it
  * @param the stack that need to be free
+ * @param options - the search options (inline nodes are released by clearNode)
+ * @param freeNode - the free function for pNode
  */
-void freeStack(Stack* stack)
+void freeStack(Stack* stack, const SearchOptions* options, freeNodeFunc freeNode)
 {
-	Node* p1;
-	Node* p2;
-	freeNodeFunc freeNode;
+	size_t index;
+	char* entry;
 	
-	if(!(stack == NULL))
+	for(index = 0; index < stack->_size; index++)
 	{
-		p1 = stack->_top;
-		while(p1)
+		entry = stackEntry(stack, index);
+		releaseNode(stack, stack->_nodeSize ? (pNode)entry : *(pNode*)entry, options, freeNode);
+	}
+	free(stack->_entries);
+	stack->_entries = NULL;
+	stack->_size = stack->_capacity = 0;
+}
+
+/**
+ * @def stackGrow
+ * @brief add an entry on top of the stack, doubling the stack when it is full
+ * @param depth - the depth of the entry node
+ * @return the new entry, NULL if allocation failed
+ */
+static char* stackGrow(Stack* stack, unsigned int depth)
+{
+	if(stack->_size == stack->_capacity)
+	{
+		size_t capacity = stack->_capacity ? 2 * stack->_capacity : STACK_INITIAL_CAPACITY;
+		char* entries = (char*)realloc(stack->_entries, capacity * stack->_entrySize);
+		if(entries == NULL)
 		{
-			p2 = p1;
-			p1 = p1->_next;
-			freeNode(p2->_data);
-			free(p2);
+			//allocation failed
+			return NULL;
 		}
-		free(stack);
-		stack = NULL;
+		stack->_entries = entries;
+		stack->_capacity = capacity;
 	}
+	
+	char* entry = stackEntry(stack, stack->_size++);
+	*entryDepth(stack, entry) = depth;
+	return entry;
 }
 
 /**
  * @def push 
- * @brief copy given pNode into the stack 
- * @param stack - where the new pNode is copy to
- * @param data - the pNode we need to copy do the stack
- * @param copyNode - the copy function for pNode
+ * @brief move given pNode into the stack - the stack owns it from now. inline node is copied 
+ * 		into the stack and its heap block is freed.
+ * @param stack - where the new pNode is move to
+ * @param data - the pNode we need to move to the stack
+ * @param depth - the depth of data in the tree
+ * @return 1 on success, 0 if allocation failed
  */
-void push(Stack* stack, pNode data, copyNodeFunc copyNode)
+int push(Stack* stack, pNode data, unsigned int depth)
 {
-	Node* node = (Node*)malloc(sizeof(Node));
-	// check allocation success
-	if(node == NULL)
+	char* entry = stackGrow(stack, depth);
+	if(entry == NULL)
 	{
-		//allocation failed
+		return 0;
 	}
 	
-	node->_data = copyNode(data);
-	node->_next = stack->_top;
-	stack->_top = node;
+	if(stack->_nodeSize)
+	{
+		memcpy(entry, data, stack->_nodeSize);
+		free(data);
+	}
+	else
+	{
+		*(pNode*)entry = data;
+	}
+	return 1;
+}
+
+/**
+ * @def pushInline
+ * @brief move inline node into the stack - its bytes are copied and the stack owns what it holds
+ * 		from now, the block itself stays with the caller
+ * @return 1 on success, 0 if allocation failed
+ */
+static int pushInline(Stack* stack, pNode block, unsigned int depth)
+{
+	char* entry = stackGrow(stack, depth);
+	if(entry == NULL)
+	{
+		return 0;
+	}
+	memcpy(entry, block, stack->_nodeSize);
+	return 1;
 }
 /**
  * @def pop 
- * @brief pop the head pNode from the given stack 
+ * @brief pop the head pNode from the given stack - the caller owns it from now
  * @param stack - the stack that we want to pop it head out
- * @param headData points to the head of the stack
- * @param copyNode - the copy function for pNode
- * @param freeNode - the free function for pNode
+ * @param headData points to the head of the stack. inline node is copied into current.
+ * @param depth - points to the depth of the head
+ * @param current - nodeSize bytes buffer for inline node
  */
-int pop(Stack* stack, pNode* headData, copyNodeFunc copyNode, freeNodeFunc freeNode)
+int pop(Stack* stack, pNode* headData, unsigned int* depth, pNode current)
 {
-	if(stack == NULL)
+	if(stack->_size == 0)
 	{
 		return 0;
 	}
-	if(stack->_top == NULL)
+	char* entry = stackEntry(stack, --stack->_size);
+
+	if(stack->_nodeSize)
 	{
-		return 0;
+		memcpy(current, entry, stack->_nodeSize);
+		*headData = current;
+	}
+	else
+	{
+		*headData = *(pNode*)entry;
 	}
-	Node *node = stack->_top;
+	*depth = *entryDepth(stack, entry);
+	
+	return 1; 
+}
+
+/**
+ * @def heapBefore
+ * @brief heap order - higher value first, on equal values the newest node first
+ * @return True if entry a should be above entry b
+ */
+static int heapBefore(const HeapEntry* a, const HeapEntry* b)
+{
+	return a->_value > b->_value || (a->_value == b->_value && a->_order > b->_order);
+}
 
-	*headData = copyNode(node->_data);
-	stack->_top = node->_next;
+/**
+ * @def heapPush
+ * @brief move given pNode into the heap (the heap owns it from now)
+ * @param heap - the heap
+ * @param data - the pNode
+ * @param value - the pNode rank
+ * @return 1 on success, 0 if allocation failed
+ */
+static int heapPush(Heap* heap, pNode data, unsigned long value)
+{
+	if(heap->_size == heap->_capacity)
+	{
+		size_t capacity = heap->_capacity ? 2 * heap->_capacity : HEAP_INITIAL_CAPACITY;
+		HeapEntry* entries = (HeapEntry*)realloc(heap->_entries, capacity * sizeof(HeapEntry));
+		if(entries == NULL)
+		{
+			//allocation failed
+			return 0;
+		}
+		heap->_entries = entries;
+		heap->_capacity = capacity;
+	}
 	
-	freeNode(node->_data);
-	free(node);
+	HeapEntry entry = {data, value, heap->_pushed++};
+	size_t index = heap->_size++;
+	// sift up
+	while(index > 0 && heapBefore(&entry, &heap->_entries[(index - 1) / 2]))
+	{
+		heap->_entries[index] = heap->_entries[(index - 1) / 2];
+		index = (index - 1) / 2;
+	}
+	heap->_entries[index] = entry;
+	return 1;
+}
+
+/**
+ * @def heapPop
+ * @brief take the top pNode out of the heap
+ * @param heap - the heap
+ * @param headData - points to the top pNode, the caller owns it
+ * @return 1 on success, 0 if the heap is empty
+ */
+static int heapPop(Heap* heap, pNode* headData)
+{
+	if(heap->_size == 0)
+	{
+		return 0;
+	}
+	*headData = heap->_entries[0]._data;
 	
-	return 1; 
+	HeapEntry last = heap->_entries[--heap->_size];
+	size_t index = 0, child;
+	// sift down
+	while((child = 2 * index + 1) < heap->_size)
+	{
+		if(child + 1 < heap->_size && heapBefore(&heap->_entries[child + 1], &heap->_entries[child]))
+		{
+			child++;
+		}
+		if(!heapBefore(&heap->_entries[child], &last))
+		{
+			break;
+		}
+		heap->_entries[index] = heap->_entries[child];
+		index = child;
+	}
+	if(heap->_size > 0)
+	{
+		heap->_entries[index] = last;
+	}
+	return 1;
 }
 
 /**
- * @brief getBest This function returns the best valued node in a tree using
- * DFS algorithm.
- * @param head The head of the tree
- * @param getChildren A function that gets a node and a pointer to array of nodes.
- * the function allocates memory for an array of all the children of the node, and
- * returns the number of the children.
- * @param getVal A function that gets a node and returns its value, as int
- * @param freeNode A function that frees node from memory.
- * this function will be called for each Node returns by getChildren.
- * @param best The best available value for a node, when the function encounters
- * a node with that value it stops looking and returns it.
- * If the best value can't be determined, pass UINT_MAX (defined in limits.h)
- * for that param.
- * @param copy A function that do deep copy of Node.
- * @return The best valued node in the tree
- * In case of an error, or when all the nodes in the tree valued zero the returns
- * Node is NULL.
- * If some nodes shares the best valued, the function returns the first one it encounters.
+ * @def freeHeap
+ * @brief free the heap nodes and entries
+ * @param heap - the heap
+ * @param freeNode - the free function for pNode
  */
-pNode getBest(pNode head, getNodeChildrenFunc getChildren, getNodeValFunc getVal, 
-			  freeNodeFunc freeNode, copyNodeFunc copy, unsigned int best)
+static void freeHeap(Heap* heap, freeNodeFunc freeNode)
 {
-	// check if given tree is NULL 
-	if(head == NULL)
-	{ 
-		printf("no tree is given\n");
-		return NULL;
+	size_t index;
+	for(index = 0; index < heap->_size; index++)
+	{
+		freeNode(heap->_entries[index]._data);
+	}
+	free(heap->_entries);
+	heap->_entries = NULL;
+	heap->_size = heap->_capacity = 0;
+}
+
+/**
+ * @def fitsBudget
+ * @brief check that one more node fits the memory budget
+ * @param held - number of nodes held now
+ * @param options - the search options
+ * @return True if another node may be held
+ */
+static int fitsBudget(size_t held, const SearchOptions* options)
+{
+	size_t budget = options->memoryBudget[options->strategy];
+	return budget == 0 || held < budget;
+}
+
+/**
+ * @def nodeRank
+ * @brief the order of the node in the best first heap and the beam - its rank, or its value when
+ * 		the options have no rank
+ */
+static unsigned long nodeRank(pNode node, getNodeValFunc getVal, const SearchOptions* options)
+{
+	return options->rank != NULL ? options->rank(node) : getVal(node);
+}
+
+/**
+ * @def visitNode
+ * @brief compare the node with the best node found until now and keep a copy of it if it better
+ * @param node - the visited node (still owned by the caller)
+ * @param result - the best node until now
+ * @return True if the node has the best value - the search is over
+ */
+static int visitNode(pNode node, getNodeValFunc getVal, freeNodeFunc freeNode, copyNodeFunc copy,
+					 unsigned int best, SearchResult* result)
+{
+	unsigned int currValue = getVal(node);
+	// check if currValue is the best we need to find then we finish
+	if(currValue == best)
+	{
+		freeNode(result->_maxNode);
+		result->_maxValue = currValue;
+		result->_maxNode = copy(node);
+		return TRUE;
+	}
+	// if currValue isn't the best but better than the maxValue we find until now
+	if(currValue > result->_maxValue)
+	{
+		freeNode(result->_maxNode);
+		result->_maxValue = currValue;
+		result->_maxNode = copy(node);
 	}
+	return FALSE;
+}
+
+/**
+ * @def depthFirst
+ * @brief dfs from head (the search owns head), children deeper than depthLimit are not expanded
+ * @param depthLimit - max depth to expand, NO_DEPTH_LIMIT for unlimited
+ * @param cut - set to True if some node was not expanded because of the depth limit
+ * @param result - the best node found
+ * @return True if the best value was found
+ */
+static int depthFirst(pNode head, getNodeChildrenFunc getChildren, getNodeValFunc getVal, 
+					  freeNodeFunc freeNode, copyNodeFunc copy, unsigned int best, 
+					  const SearchOptions* options, unsigned int depthLimit, int* cut,
+					  SearchResult* result)
+{
+	Stack stack;
+	size_t nodeSize = options->clearNode ? options->nodeSize : 0;
+	// inline nodes are popped into this buffer - the only node the stack hands out at a time
+	pNode current = nodeSize ? malloc(nodeSize) : NULL;
+	// inline children are written into this buffer and copied into the stack from there
+	int inlineChildren = nodeSize && options->getChildrenInto && options->maxChildren > 0;
+	char* childBuffer = inlineChildren ? (char*)malloc(options->maxChildren * nodeSize) : NULL;
 	
-	Stack* stack = stackAlloc(sizeof(pNode));
-	if(stack == NULL)
+	stackInit(&stack, nodeSize);
+	if((nodeSize && current == NULL) || (inlineChildren && childBuffer == NULL) || \
+	   !push(&stack, head, 0))
 	{
+		free(current);
+		free(childBuffer);
 		freeNode(head);
-		return NULL;
+		return FALSE;
 	}
-	
-	push(stack, head, copy);
-	freeNode(head);
 	head = NULL;
 	
 	pNode currentNode;
 	pNode* children = NULL;
-	int childrenAmount, childIndex;
-	unsigned int maxValue = 0, currValue;
-	pNode maxNode = NULL;
+	int childrenAmount, childIndex, found = FALSE;
+	unsigned int depth;
 	
-	while(pop(stack, &currentNode, copy, freeNode))
+	while(!found && pop(&stack, &currentNode, &depth, current))
 	{ 
-		currValue = getVal(currentNode);
-		// check if currValue is the best we need to find then we finish
-		if(currValue == best)
-		{	
+		found = visitNode(currentNode, getVal, freeNode, copy, best, result);
+		if(!found && depthLimit != NO_DEPTH_LIMIT && depth >= depthLimit)
+		{
+			*cut = TRUE;
+		}
+		else if(!found && inlineChildren)
+		{
+			childrenAmount = options->getChildrenInto(currentNode, childBuffer, options->maxChildren);
+			for(childIndex = childrenAmount - 1 ; childIndex >= 0; childIndex--)
+			{
+				// children that do not fit the memory budget are pruned
+				if(!fitsBudget(stack._size, options) || \
+				   !pushInline(&stack, childBuffer + childIndex * nodeSize, depth + 1))
+				{
+					options->clearNode(childBuffer + childIndex * nodeSize);
+				}
+			}
+		}
+		else if(!found)
+		{
+			childrenAmount = getChildren(currentNode, &children);
+			for(childIndex = childrenAmount - 1 ; childIndex >= 0; childIndex--)
+			{
+				// children that do not fit the memory budget are pruned
+				if(!fitsBudget(stack._size, options) || \
+				   !push(&stack, children[childIndex], depth + 1))
+				{
+					freeNode(children[childIndex]);
+				}
+			}
 			free(children);
 			children = NULL;
-			freeStack(stack);
-			stack = NULL;
-			freeNode(maxNode);
-			maxNode = copy(currentNode);
-			freeNode(currentNode);
-			break;
 		}
-		// if currValue isn't the best but better than the maxValue we find until now
-		if(currValue > maxValue)
+		releaseNode(&stack, currentNode, options, freeNode);
+	}	
+	
+	freeStack(&stack, options, freeNode);
+	free(current);
+	free(childBuffer);
+	return found;
+}
+
+/**
+ * @def bestFirst
+ * @brief best first search from head (the search owns head) with binary heap
+ * @param result - the best node found
+ */
+static void bestFirst(pNode head, getNodeChildrenFunc getChildren, getNodeValFunc getVal, 
+					  freeNodeFunc freeNode, copyNodeFunc copy, unsigned int best, 
+					  const SearchOptions* options, SearchResult* result)
+{
+	Heap heap = {NULL, 0, 0, 0};
+	if(!heapPush(&heap, head, nodeRank(head, getVal, options)))
+	{
+		freeNode(head);
+		return;
+	}
+	
+	pNode currentNode;
+	pNode* children = NULL;
+	int childrenAmount, childIndex;
+	
+	while(heapPop(&heap, &currentNode))
+	{
+		if(visitNode(currentNode, getVal, freeNode, copy, best, result))
 		{
-			freeNode(maxNode);
-			maxValue = currValue;
-			maxNode = copy(currentNode);
+			freeNode(currentNode);
+			break;
 		}
-		
 		childrenAmount = getChildren(currentNode, &children);
-		for(childIndex = childrenAmount - 1 ; childIndex >= 0; childIndex--)
+		for(childIndex = 0; childIndex < childrenAmount; childIndex++)
 		{
-			push(stack, children[childIndex], copy);
-			freeNode(children[childIndex]);
+			// children that do not fit the memory budget are pruned
+			if(!fitsBudget(heap._size, options) || \
+			   !heapPush(&heap, children[childIndex], \
+								 nodeRank(children[childIndex], getVal, options)))
+			{
+				freeNode(children[childIndex]);
+			}
 		}
 		free(children);
 		children = NULL;
 		freeNode(currentNode);
-	}	
+	}
+	
+	freeHeap(&heap, freeNode);
+}
+
+/**
+ * @def beamSearch
+ * @brief beam search from head (the search owns head) - each level keeps the beamWidth highest 
+ * 		valued children of the previous level
+ * @param result - the best node found
+ */
+static void beamSearch(pNode head, getNodeChildrenFunc getChildren, getNodeValFunc getVal, 
+					   freeNodeFunc freeNode, copyNodeFunc copy, unsigned int best, 
+					   const SearchOptions* options, SearchResult* result)
+{
+	unsigned int beamWidth = options->beamWidth ? options->beamWidth : 1;
+	Heap level = {NULL, 0, 0, 0};
+	Heap nextLevel = {NULL, 0, 0, 0};
+	pNode currentNode;
+	pNode* children = NULL;
+	int childrenAmount, childIndex, found = FALSE;
 	
-	currentNode = NULL;
+	if(!heapPush(&level, head, nodeRank(head, getVal, options)))
+	{
+		freeNode(head);
+		return;
+	}
 	
-	freeStack(stack);
-	free(children);
+	while(!found && level._size > 0)
+	{
+		// expand the level from its best node, the next level heap collects all the children
+		while(!found && heapPop(&level, &currentNode))
+		{
+			found = visitNode(currentNode, getVal, freeNode, copy, best, result);
+			if(!found)
+			{
+				childrenAmount = getChildren(currentNode, &children);
+				for(childIndex = 0; childIndex < childrenAmount; childIndex++)
+				{
+					// children that do not fit the memory budget are pruned
+					if(!fitsBudget(nextLevel._size, options) || \
+					   !heapPush(&nextLevel, children[childIndex], \
+									 nodeRank(children[childIndex], getVal, options)))
+					{
+						freeNode(children[childIndex]);
+					}
+				}
+				free(children);
+				children = NULL;
+			}
+			freeNode(currentNode);
+		}
+		freeHeap(&level, freeNode);
+		
+		// keep only the beamWidth best children
+		while(level._size < beamWidth && heapPop(&nextLevel, &currentNode))
+		{
+			if(!heapPush(&level, currentNode, nodeRank(currentNode, getVal, options)))
+			{
+				freeNode(currentNode);
+			}
+		}
+		freeHeap(&nextLevel, freeNode);
+		nextLevel._pushed = 0;
+	}
 	
-	return maxNode;
+	freeHeap(&level, freeNode);
 }
+
+/**
+ * @overload genericdfs.h
+ */
+pNode searchBest(pNode head, getNodeChildrenFunc getChildren, getNodeValFunc getVal, 
+				 freeNodeFunc freeNode, copyNodeFunc copy, unsigned int best,
+				 const SearchOptions* options)
+{
+	// check if given tree is NULL 
+	if(head == NULL)
+	{ 
+		printf("no tree is given\n");
+		return NULL;
+	}
+	
+	SearchOptions defaultOptions = {SEARCH_DFS, {0}, 0, 0, 0, NULL, NULL, NULL, 0};
+	if(options == NULL)
+	{
+		options = &defaultOptions;
+	}
 	
-				  
-				 
+	SearchResult result = {0, NULL};
+	int cut;
+	unsigned int depthLimit;
+	pNode pass;
 	
+	if(options->strategy < SEARCH_DFS || options->strategy >= SEARCH_STRATEGIES)
+	{
+		printf("unknown search strategy\n");
+		freeNode(head);
+		return NULL;
+	}
+	
+	switch(options->strategy)
+	{
+		case SEARCH_BEST_FIRST:
+			bestFirst(head, getChildren, getVal, freeNode, copy, best, options, &result);
+			break;
+		case SEARCH_BEAM:
+			beamSearch(head, getChildren, getVal, freeNode, copy, best, options, &result);
+			break;
+		case SEARCH_ITERATIVE_DEEPENING:
+			// each pass starts from a copy of head, the last pass gets head itself
+			for(depthLimit = 1; ; depthLimit++)
+			{
+				cut = FALSE;
+				if(options->maxDepth != 0 && depthLimit >= options->maxDepth)
+				{
+					depthFirst(head, getChildren, getVal, freeNode, copy, best, options, 
+							   depthLimit, &cut, &result);
+					break;
+				}
+				pass = copy(head);
+				if(pass == NULL)
+				{
+					//allocation failed - the best node of the passes so far is the result
+					freeNode(head);
+					break;
+				}
+				if(depthFirst(pass, getChildren, getVal, freeNode, copy, best, options, depthLimit,
+							  &cut, &result) || !cut)
+				{
+					freeNode(head);
+					break;
+				}
+			}
+			break;
+		case SEARCH_DFS:
+		default:
+			cut = FALSE;
+			depthFirst(head, getChildren, getVal, freeNode, copy, best, options, NO_DEPTH_LIMIT, 
+					   &cut, &result);
+			break;
+	}
+	
+	return result._maxNode;
+}
+
+/**
+ * @overload genericdfs.h
+ */
+pNode getBest(pNode head, getNodeChildrenFunc getChildren, getNodeValFunc getVal, 
+			  freeNodeFunc freeNode, copyNodeFunc copy, unsigned int best)
+{
+	return searchBest(head, getChildren, getVal, freeNode, copy, best, NULL);
+}
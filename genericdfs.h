@@ -0,0 +1,147 @@
+/**
+ * @file genericdfs.h
+ * @author guffi
+ *
+ * @brief The header file of genericdfs - search for the best valued node of a tree that is given
+ * 		  only by callbacks.
+ */
+#ifndef GENERICDFS_H
+#define GENERICDFS_H
+
+#include <stddef.h>
+
+/**
+ * @def pNode
+ * @brief a generic tree node
+ */
+typedef void* pNode;
+
+/**
+ * @def getNodeChildrenFunc
+ * @brief gets a node and a pointer to array of nodes, allocates the array of all the node
+ * 		children and returns the number of the children.
+ */
+typedef int (*getNodeChildrenFunc)(pNode, pNode**);
+
+/**
+ * @def getNodeChildrenIntoFunc
+ * @brief gets a node and a buffer of capacity fixed size node blocks, writes all the node children
+ * 		into the buffer and returns the number of the children.
+ */
+typedef int (*getNodeChildrenIntoFunc)(pNode, pNode, int);
+
+/**
+ * @def getNodeValFunc
+ * @brief gets a node and returns its value
+ */
+typedef unsigned int (*getNodeValFunc)(pNode);
+
+/**
+ * @def getNodeRankFunc
+ * @brief gets a node and returns how promising it is, higher first
+ */
+typedef unsigned long (*getNodeRankFunc)(pNode);
+
+/**
+ * @def freeNodeFunc
+ * @brief frees node from memory
+ */
+typedef void (*freeNodeFunc)(pNode);
+
+/**
+ * @def copyNodeFunc
+ * @brief deep copy of node
+ */
+typedef pNode (*copyNodeFunc)(pNode);
+
+/**
+ * @def clearNodeFunc
+ * @brief frees what the node holds, but not the node itself
+ */
+typedef void (*clearNodeFunc)(pNode);
+
+/**
+ * @def enum SearchStrategy
+ * @brief the order in which searchBest visits the tree
+ * 		SEARCH_DFS - depth first, children in the order getChildren returns them.
+ * 		SEARCH_BEST_FIRST - always expand the highest ranked node found so far (binary heap), on
+ * 			equal ranks the newest node first.
+ * 		SEARCH_ITERATIVE_DEEPENING - depth first limited to depth 1, 2, 3... until the best value
+ * 			is found or a whole pass is done without reaching the limit.
+ * 		SEARCH_BEAM - level by level, keeping only the beamWidth highest ranked nodes of each level.
+ */
+typedef enum SearchStrategy
+{
+	SEARCH_DFS,
+	SEARCH_BEST_FIRST,
+	SEARCH_ITERATIVE_DEEPENING,
+	SEARCH_BEAM,
+	SEARCH_STRATEGIES
+} SearchStrategy;
+
+/**
+ * @def struct SearchOptions
+ * @brief the search configuration of one searchBest call
+ * 		strategy - the search order.
+ * 		memoryBudget - max nodes each strategy holds at once (its stack, heap or beam level),
+ * 			indexed by SearchStrategy - so one options struct keeps a budget fit for each order.
+ * 			children that do not fit are pruned so the search may miss the best node. 0 for
+ * 			unlimited.
+ * 		beamWidth - the nodes kept per level by SEARCH_BEAM (0 is treated as 1).
+ * 		maxDepth - the deepest level SEARCH_ITERATIVE_DEEPENING tries, 0 for unlimited.
+ * 		nodeSize, clearNode - for node that is a fixed size block allocated by malloc and may be
+ * 			moved with memcpy: its size and a function that frees what it holds (freeNode without
+ * 			the final free). the dfs stack then keeps the nodes inline. 0 and NULL otherwise.
+ * 		rank - orders the SEARCH_BEST_FIRST heap and the SEARCH_BEAM levels, for trees where many
+ * 			nodes share a value (a beam of equal nodes is cut at random). NULL to order by getVal.
+ * 		getChildrenInto, maxChildren - for inline node: a function that writes the children straight
+ * 			into a buffer of maxChildren nodes the dfs keeps for the whole search, so no node is
+ * 			allocated on the way to the stack. NULL and 0 to use getChildren.
+ */
+typedef struct SearchOptions
+{
+	SearchStrategy strategy;
+	size_t memoryBudget[SEARCH_STRATEGIES];
+	unsigned int beamWidth;
+	unsigned int maxDepth;
+	size_t nodeSize;
+	clearNodeFunc clearNode;
+	getNodeRankFunc rank;
+	getNodeChildrenIntoFunc getChildrenInto;
+	int maxChildren;
+} SearchOptions;
+
+/**
+ * @brief getBest This function returns the best valued node in a tree using
+ * DFS algorithm.
+ * @param head The head of the tree
+ * @param getChildren A function that gets a node and a pointer to array of nodes.
+ * the function allocates memory for an array of all the children of the node, and
+ * returns the number of the children.
+ * @param getVal A function that gets a node and returns its value, as int
+ * @param freeNode A function that frees node from memory.
+ * this function will be called for each Node returns by getChildren.
+ * @param best The best available value for a node, when the function encounters
+ * a node with that value it stops looking and returns it.
+ * If the best value can't be determined, pass UINT_MAX (defined in limits.h)
+ * for that param.
+ * @param copy A function that do deep copy of Node.
+ * @return The best valued node in the tree
+ * In case of an error, or when all the nodes in the tree valued zero the returns
+ * Node is NULL.
+ * If some nodes shares the best valued, the function returns the first one it encounters.
+ */
+pNode getBest(pNode head, getNodeChildrenFunc getChildren, getNodeValFunc getVal,
+			  freeNodeFunc freeNode, copyNodeFunc copy, unsigned int best);
+
+/**
+ * @brief searchBest same as getBest, with the search strategy and memory budget given by options.
+ * @param options the search configuration, NULL for the getBest defaults (unlimited DFS)
+ * @return The best valued node the search encountered, NULL on error or when all the nodes it
+ * encountered valued zero.
+ */
+pNode searchBest(pNode head, getNodeChildrenFunc getChildren, getNodeValFunc getVal,
+				 freeNodeFunc freeNode, copyNodeFunc copy, unsigned int best,
+				 const SearchOptions* options);
+
+#endif
@@ -0,0 +1,654 @@
+/**
+ * @file sudukubatch.c
+ * @author guffi
+ * 
+ * @brief This file implement the sudukubatch.h function. 
+ */
+//-------------------------------------include------------------------------------------------------
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <pthread.h>
+#include "sudukusolve.h"
+#include "sudukubatch.h"
+#include "sudukutrace.h"
+
+//------------------------------------const definitions---------------------------------------------
+/**
+ * @def QUEUE_SIZE 64
+ * @brief the capacity of each queue between the stages (power of 2)
+ */
+#define QUEUE_SIZE 64
+/**
+ * @def BATCH_WINDOW 256
+ * @brief max files that were read but not printed yet - bounds the results waiting for a slow
+ * 		file before them
+ */
+#define BATCH_WINDOW 256
+/**
+ * @def BATCH_SPINS 16
+ * @brief times a stage yields and tries again before it sleeps until the other side moves
+ */
+#define BATCH_SPINS 16
+/**
+ * @def INVALID_COMMAND -1
+ * @brief value for all invalid command
+ */
+#define INVALID_COMMAND -1
+/**
+ * @def JOB_FAILED "allocation failed\n"
+ * @brief the output of a file whose job could not be made
+ */
+#define JOB_FAILED "allocation failed\n"
+/**
+ * @def BATCH_FAILED "can not run the batch\n"
+ * @brief printed to stderr when the pipeline can not start or can not go on
+ */
+#define BATCH_FAILED "can not run the batch\n"
+
+#define TRUE 1
+#define FALSE 0
+
+/**
+ * @def struct BatchJob
+ * @brief one file in the pipeline - its place in the batch, the parsed table (the solution after 
+ * 		the solver stage, NULL if there is none) and its size (0 if it did not parse), the
+ * 		message of a file that failed to parse, and the fixed message of a job that could not
+ * 		even hold one (failure)
+ */
+typedef struct BatchJob
+{
+	int index;
+	Suduku* table;
+	int tableSize;
+	char* message;
+	size_t messageLength;
+	const char* failure;
+	SolveStats stats;
+} BatchJob;
+
+/**
+ * @def struct BatchSignal
+ * @brief where a stage sleeps after BATCH_SPINS failed tries - the other side wakes it when it
+ * 		moves, and takes the lock only when someone is waiting (waiters), so the lock free fast
+ * 		path stays lock free.
+ */
+typedef struct BatchSignal
+{
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	atomic_int waiters;
+} BatchSignal;
+
+/**
+ * @def struct QueueCell
+ * @brief one cell of the queue - the job and the sequence number that tells whose turn it is
+ */
+typedef struct QueueCell
+{
+	atomic_size_t sequence;
+	BatchJob* job;
+} QueueCell;
+
+/**
+ * @def struct JobQueue
+ * @brief bounded lock free multi producer multi consumer queue (cells with sequence numbers).
+ * 		producers and consumers each own their position counter on its own cache line, a side
+ * 		that finds it full or empty for long sleeps on its signal.
+ */
+typedef struct JobQueue
+{
+	QueueCell cells[QUEUE_SIZE];
+	_Alignas(64) atomic_size_t enqueuePos;
+	_Alignas(64) atomic_size_t dequeuePos;
+	_Alignas(64) BatchSignal signal;
+} JobQueue;
+
+/**
+ * @def struct Batch
+ * @brief the state shared by the pipeline stages
+ */
+typedef struct Batch
+{
+	char* const* fileNames;
+	int amount;
+	int workers;
+	const SolveConfig* config;
+	JobQueue parsed;
+	JobQueue solved;
+	atomic_int printed;
+	BatchSignal printedSignal;
+	atomic_int read;
+} Batch;
+
+//-------------------------------------------functions----------------------------------------------
+/**
+ * @def signalInit
+ * @brief initialize signal with no waiters
+ */
+static void signalInit(BatchSignal* signal)
+{
+	pthread_mutex_init(&signal->lock, NULL);
+	pthread_cond_init(&signal->changed, NULL);
+	atomic_init(&signal->waiters, 0);
+}
+
+/**
+ * @def signalDestroy
+ * @brief free what the signal holds
+ */
+static void signalDestroy(BatchSignal* signal)
+{
+	pthread_mutex_destroy(&signal->lock);
+	pthread_cond_destroy(&signal->changed);
+}
+
+/**
+ * @def signalWaitBegin
+ * @brief lock the signal and count this thread as waiting - from here every change the other side
+ * 		makes is followed by a wake, so the condition can be checked again and slept on with
+ * 		signalWait until it holds
+ */
+static void signalWaitBegin(BatchSignal* signal)
+{
+	pthread_mutex_lock(&signal->lock);
+	atomic_fetch_add(&signal->waiters, 1);
+	// the count is seen before the condition is checked again - pairs with the fence of signalWake
+	atomic_thread_fence(memory_order_seq_cst);
+}
+
+/**
+ * @def signalWait
+ * @brief sleep until the signal is woken (between signalWaitBegin and signalWaitEnd)
+ */
+static void signalWait(BatchSignal* signal)
+{
+	pthread_cond_wait(&signal->changed, &signal->lock);
+}
+
+/**
+ * @def signalWaitEnd
+ * @brief stop waiting and unlock the signal
+ */
+static void signalWaitEnd(BatchSignal* signal)
+{
+	atomic_fetch_sub(&signal->waiters, 1);
+	pthread_mutex_unlock(&signal->lock);
+}
+
+/**
+ * @def signalWake
+ * @brief wake the threads waiting on the signal after a change, if there are any
+ */
+static void signalWake(BatchSignal* signal)
+{
+	// the change is seen before the waiters are counted - pairs with the fence of signalWaitBegin
+	atomic_thread_fence(memory_order_seq_cst);
+	if(atomic_load_explicit(&signal->waiters, memory_order_relaxed) > 0)
+	{
+		pthread_mutex_lock(&signal->lock);
+		pthread_cond_broadcast(&signal->changed);
+		pthread_mutex_unlock(&signal->lock);
+	}
+}
+
+/**
+ * @def queueInit
+ * @brief initialize empty queue
+ */
+static void queueInit(JobQueue* queue)
+{
+	size_t index;
+	for(index = 0; index < QUEUE_SIZE; index++)
+	{
+		atomic_init(&queue->cells[index].sequence, index);
+		queue->cells[index].job = NULL;
+	}
+	atomic_init(&queue->enqueuePos, 0);
+	atomic_init(&queue->dequeuePos, 0);
+	signalInit(&queue->signal);
+}
+
+/**
+ * @def tryEnqueue
+ * @brief add job to the queue if it has room
+ * @return False if the queue is full
+ */
+static int tryEnqueue(JobQueue* queue, BatchJob* job)
+{
+	size_t pos = atomic_load_explicit(&queue->enqueuePos, memory_order_relaxed);
+	QueueCell* cell;
+	size_t sequence;
+	
+	for(;;)
+	{
+		cell = &queue->cells[pos & (QUEUE_SIZE - 1)];
+		sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+		if(sequence == pos)
+		{
+			// the cell is free in this round - claim it
+			if(atomic_compare_exchange_weak_explicit(&queue->enqueuePos, &pos, pos + 1, \
+													 memory_order_relaxed, memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if(sequence < pos)
+		{
+			return FALSE;
+		}
+		else
+		{
+			pos = atomic_load_explicit(&queue->enqueuePos, memory_order_relaxed);
+		}
+	}
+	
+	cell->job = job;
+	atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+	return TRUE;
+}
+
+/**
+ * @def tryDequeue
+ * @brief take the oldest job from the queue if there is one
+ * @return False if the queue is empty
+ */
+static int tryDequeue(JobQueue* queue, BatchJob** job)
+{
+	size_t pos = atomic_load_explicit(&queue->dequeuePos, memory_order_relaxed);
+	QueueCell* cell;
+	size_t sequence;
+	
+	for(;;)
+	{
+		cell = &queue->cells[pos & (QUEUE_SIZE - 1)];
+		sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+		if(sequence == pos + 1)
+		{
+			// the cell holds a job of this round - claim it
+			if(atomic_compare_exchange_weak_explicit(&queue->dequeuePos, &pos, pos + 1, \
+													 memory_order_relaxed, memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if(sequence < pos + 1)
+		{
+			return FALSE;
+		}
+		else
+		{
+			pos = atomic_load_explicit(&queue->dequeuePos, memory_order_relaxed);
+		}
+	}
+	
+	*job = cell->job;
+	atomic_store_explicit(&cell->sequence, pos + QUEUE_SIZE, memory_order_release);
+	return TRUE;
+}
+
+/**
+ * @def enqueue
+ * @brief add job to the queue - while the queue is full, yields BATCH_SPINS times and then sleeps
+ * 		until a dequeue makes room
+ */
+static void enqueue(JobQueue* queue, BatchJob* job)
+{
+	int spins;
+	for(spins = 0; !tryEnqueue(queue, job); spins++)
+	{
+		if(spins < BATCH_SPINS)
+		{
+			sched_yield();
+			continue;
+		}
+		signalWaitBegin(&queue->signal);
+		while(!tryEnqueue(queue, job))
+		{
+			signalWait(&queue->signal);
+		}
+		signalWaitEnd(&queue->signal);
+		break;
+	}
+	signalWake(&queue->signal);
+}
+
+/**
+ * @def dequeue
+ * @brief take the oldest job from the queue - while the queue is empty, yields BATCH_SPINS times
+ * 		and then sleeps until an enqueue adds a job
+ */
+static BatchJob* dequeue(JobQueue* queue)
+{
+	BatchJob* job;
+	int spins;
+	for(spins = 0; !tryDequeue(queue, &job); spins++)
+	{
+		if(spins < BATCH_SPINS)
+		{
+			sched_yield();
+			continue;
+		}
+		signalWaitBegin(&queue->signal);
+		while(!tryDequeue(queue, &job))
+		{
+			signalWait(&queue->signal);
+		}
+		signalWaitEnd(&queue->signal);
+		break;
+	}
+	signalWake(&queue->signal);
+	return job;
+}
+
+/**
+ * @def windowFull
+ * @brief check if the reader has to wait for the printer before it reads file index
+ */
+static int windowFull(Batch* batch, int index)
+{
+	return index - atomic_load_explicit(&batch->printed, memory_order_acquire) >= BATCH_WINDOW;
+}
+
+/**
+ * @def readJob
+ * @brief read and parse one file of the batch
+ * @param const char* fileName - the file name
+ * @param BatchJob* job - the job to fill, message is set if the file could not be parsed
+ * @param SolveConfig* config - the solve config, for the trace of the parse
+ */
+static void readJob(const char* fileName, BatchJob* job, const SolveConfig* config)
+{
+	FILE* messages = open_memstream(&job->message, &job->messageLength);
+	if(messages == NULL)
+	{
+		//allocation failed - the file is not read, its output is the failure
+		job->message = NULL;
+		job->failure = JOB_FAILED;
+		return;
+	}
+	
+	long start = traceStart();
+	FILE* currentFile = fopen(fileName, "r");
+	//check if file exist
+	if(currentFile == NULL)
+	{
+		fputs(FILE_NOT_FOUND, messages);
+	}
+	else
+	{
+		job->table = parser(currentFile, fileName, messages);
+		fclose(currentFile);
+	}
+	fclose(messages);
+	job->tableSize = job->table != NULL ? job->table->tableSize : 0;
+	traceRecord(TRACE_PARSE, job->tableSize, config, start);
+	
+	if(job->table != NULL)
+	{
+		free(job->message);
+		job->message = NULL;
+	}
+}
+
+/**
+ * @def stopSolvers
+ * @brief one NULL job for each solver - a solver that takes it stops
+ */
+static void stopSolvers(Batch* batch, int solvers)
+{
+	int index;
+	for(index = 0; index < solvers; index++)
+	{
+		enqueue(&batch->parsed, NULL);
+	}
+}
+
+/**
+ * @def reader
+ * @brief reader stage - parse the files in order and pass them to the solvers. when all the 
+ * 		files are read, one NULL job per solver tells them to stop. if a job can not be made the
+ * 		reading stops there - read holds the number of files read, and a NULL job tells the
+ * 		printer.
+ */
+static void* reader(void* arg)
+{
+	Batch* batch = (Batch*)arg;
+	BatchJob* job;
+	int index, spins;
+	
+	for(index = 0; index < batch->amount; index++)
+	{
+		// keep at most BATCH_WINDOW files between this stage and the printer - the printer may be
+		// stuck behind one slow file, so after a few tries sleep until it prints
+		for(spins = 0; spins < BATCH_SPINS && windowFull(batch, index); spins++)
+		{
+			sched_yield();
+		}
+		if(windowFull(batch, index))
+		{
+			signalWaitBegin(&batch->printedSignal);
+			while(windowFull(batch, index))
+			{
+				signalWait(&batch->printedSignal);
+			}
+			signalWaitEnd(&batch->printedSignal);
+		}
+		
+		job = (BatchJob*)calloc(1, sizeof(BatchJob));
+		if(job == NULL)
+		{
+			//allocation failed
+			break;
+		}
+		job->index = index;
+		readJob(batch->fileNames[index], job, batch->config);
+		enqueue(&batch->parsed, job);
+	}
+	
+	atomic_store(&batch->read, index);
+	stopSolvers(batch, batch->workers);
+	if(index < batch->amount)
+	{
+		enqueue(&batch->solved, NULL);
+	}
+	return NULL;
+}
+
+/**
+ * @def solver
+ * @brief solver stage - replace each parsed table by its solution
+ */
+static void* solver(void* arg)
+{
+	Batch* batch = (Batch*)arg;
+	BatchJob* job;
+	
+	while((job = dequeue(&batch->parsed)) != NULL)
+	{
+		if(job->table != NULL)
+		{
+			job->table = findSolution(job->table, batch->config, &job->stats);
+		}
+		enqueue(&batch->solved, job);
+	}
+	return NULL;
+}
+
+/**
+ * @def printJob
+ * @brief print one job the way sudukusolver prints its file
+ * @return True if the job was solved
+ */
+static int printJob(BatchJob* job, const SolveConfig* config, FILE* out)
+{
+	long start = traceStart();
+	int solved = FALSE;
+	if(job->failure != NULL)
+	{
+		fputs(job->failure, out);
+	}
+	else if(job->message != NULL)
+	{
+		fwrite(job->message, 1, job->messageLength, out);
+	}
+	else if(job->table == NULL)
+	{
+		fputs(NO_SOLUTION, out);
+	}
+	else
+	{
+		solutionPrinter(out, job->table);
+		solved = TRUE;
+	}
+	// a file that did not parse has no output phase
+	if(job->message == NULL && job->failure == NULL)
+	{
+		traceRecord(TRACE_OUTPUT, job->tableSize, config, start);
+	}
+	free(job->message);
+	freeNode(job->table);
+	free(job);
+	return solved;
+}
+
+/**
+ * @def freeBatch
+ * @brief free the batch and the jobs that were not printed
+ */
+static void freeBatch(Batch* batch, BatchJob** pending)
+{
+	BatchJob* job;
+	int index;
+	while(tryDequeue(&batch->solved, &job))
+	{
+		if(job != NULL)
+		{
+			pending[job->index % BATCH_WINDOW] = job;
+		}
+	}
+	for(index = 0; index < BATCH_WINDOW; index++)
+	{
+		if(pending[index] != NULL)
+		{
+			free(pending[index]->message);
+			freeNode(pending[index]->table);
+			free(pending[index]);
+		}
+	}
+	signalDestroy(&batch->parsed.signal);
+	signalDestroy(&batch->solved.signal);
+	signalDestroy(&batch->printedSignal);
+	free(batch);
+	free(pending);
+}
+
+/**
+ * @overload sudukubatch.h
+ */
+int runBatch(char* const fileNames[], int amount, int workers, const SolveConfig* config,
+			 SolveStats* stats, FILE* out)
+{
+	if(workers <= 0 || workers > MAX_BATCH_WORKERS)
+	{
+		return INVALID_COMMAND;
+	}
+	
+	Batch* batch = (Batch*)malloc(sizeof(Batch));
+	BatchJob** pending = (BatchJob**)calloc(BATCH_WINDOW, sizeof(BatchJob*));
+	if(batch == NULL || pending == NULL)
+	{
+		//allocation failed
+		free(batch);
+		free(pending);
+		return INVALID_COMMAND;
+	}
+	batch->fileNames = fileNames;
+	batch->amount = amount;
+	batch->workers = workers;
+	batch->config = config;
+	queueInit(&batch->parsed);
+	queueInit(&batch->solved);
+	atomic_init(&batch->printed, 0);
+	signalInit(&batch->printedSignal);
+	atomic_init(&batch->read, amount);
+	
+	pthread_t readerThread;
+	pthread_t solverThreads[MAX_BATCH_WORKERS];
+	int index, started = 0, solved = 0;
+	
+	for(index = 0; index < workers; index++)
+	{
+		// a missing solver thread only means less parallelism - the others take its jobs
+		if(pthread_create(&solverThreads[started], NULL, solver, batch) == 0)
+		{
+			started++;
+		}
+	}
+	// the reader stops as many solvers as were started
+	batch->workers = started;
+	if(started == 0 || pthread_create(&readerThread, NULL, reader, batch) != 0)
+	{
+		fprintf(stderr, BATCH_FAILED);
+		stopSolvers(batch, started);
+		for(index = 0; index < started; index++)
+		{
+			pthread_join(solverThreads[index], NULL);
+		}
+		freeBatch(batch, pending);
+		return INVALID_COMMAND;
+	}
+	
+	// printer stage - results come in any order, hold them until all the files before are printed
+	BatchJob* job;
+	int next = 0, last = amount, technique;
+	if(stats != NULL)
+	{
+		memset(stats, 0, sizeof(SolveStats));
+	}
+	while(next < last)
+	{
+		job = dequeue(&batch->solved);
+		if(job == NULL)
+		{
+			// the reader stopped - only the files it read are still coming
+			last = atomic_load(&batch->read);
+			continue;
+		}
+		pending[job->index % BATCH_WINDOW] = job;
+		while(next < last && pending[next % BATCH_WINDOW] != NULL)
+		{
+			job = pending[next % BATCH_WINDOW];
+			pending[next % BATCH_WINDOW] = NULL;
+			if(stats != NULL && job->stats.peakMemory > stats->peakMemory)
+			{
+				stats->peakMemory = job->stats.peakMemory;
+			}
+			for(technique = 0; stats != NULL && technique < LOGIC_TECHNIQUES; technique++)
+			{
+				stats->logicHits[technique] += job->stats.logicHits[technique];
+			}
+			solved += printJob(job, batch->config, out);
+			next++;
+			atomic_store_explicit(&batch->printed, next, memory_order_release);
+			signalWake(&batch->printedSignal);
+		}
+	}
+	
+	pthread_join(readerThread, NULL);
+	for(index = 0; index < started; index++)
+	{
+		pthread_join(solverThreads[index], NULL);
+	}
+	
+	freeBatch(batch, pending);
+	if(last < amount)
+	{
+		fprintf(stderr, BATCH_FAILED);
+		return INVALID_COMMAND;
+	}
+	return solved;
+}
@@ -0,0 +1,38 @@
+/**
+ * @file sudukubatch.h
+ * @author guffi
+ * 
+ * @brief The header file of sudukubatch - solve many suduku files as a pipeline: a reader thread
+ * 		parses the files, solver threads search and the calling thread prints the results in 
+ * 		the order of the files. The stages are connected by bounded lock free queues, so reading
+ * 		and printing overlap with solving.
+ */ 
+#ifndef SUDUKUBATCH_H
+#define SUDUKUBATCH_H
+
+#include <stdio.h>
+#include "sudukusolve.h"
+
+/**
+ * @def MAX_BATCH_WORKERS 256
+ * @brief max solver threads
+ */
+#define MAX_BATCH_WORKERS 256
+
+/**
+ * @def runBatch
+ * @brief solve the given suduku files and print what sudukusolver prints for each of them
+ * @param char* const fileNames[] - the suduku files
+ * @param int amount - the number of files
+ * @param int workers - the number of solver threads
+ * @param SolveConfig* config - how to solve each file, NULL for ENGINE_DFS
+ * @param SolveStats* stats - set to the largest peak memory and the total deduction hits over
+ * 		the files, may be NULL
+ * @param FILE* out - where to print
+ * @return the number of files that were solved, -1 if the pipeline could not start or could not
+ * 		read all the files (the files before the failure are still printed)
+ */
+int runBatch(char* const fileNames[], int amount, int workers, const SolveConfig* config,
+			 SolveStats* stats, FILE* out);
+
+#endif
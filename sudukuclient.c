@@ -0,0 +1,306 @@
+/**
+ * @file sudukuclient.c
+ * @author guffi
+ *
+ * @brief A small client for sudukuserver. With one request it prints the server response, like
+ * 		sudukusolver prints it. With more requests it is a load test: every connection sends its
+ * 		requests one after the other, and the latency and throughput summary is printed.
+ */
+//-------------------------------------include------------------------------------------------------
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "sudukuprotocol.h"
+
+//------------------------------------const definitions---------------------------------------------
+/**
+ * @def SOCKET_PATH 1
+ * @brief the socket path location in the givan argv[]
+ */
+#define SOCKET_PATH 1
+/**
+ * @def FILE_NAME 2
+ * @brief the file name location in the givan argv[]
+ */
+#define FILE_NAME 2
+/**
+ * @def REQUESTS 3
+ * @brief the optional requests per connection location in the givan argv[]
+ */
+#define REQUESTS 3
+/**
+ * @def CONNECTIONS 4
+ * @brief the optional connections amount location in the givan argv[]
+ */
+#define CONNECTIONS 4
+/**
+ * @def MAX_CONNECTIONS 1024
+ * @brief max connections amount
+ */
+#define MAX_CONNECTIONS 1024
+/**
+ * @def INVALID_COMMAND -1
+ * @brief value for all invalid command
+ */
+#define INVALID_COMMAND -1
+/**
+ * @def NANO_IN_MICRO 1000
+ * @brief nanoseconds in microsecond
+ */
+#define NANO_IN_MICRO 1000
+/**
+ * @def MICRO_IN_SEC 1000000
+ * @brief microseconds in second
+ */
+#define MICRO_IN_SEC 1000000
+
+#define TRUE 1
+#define FALSE 0
+
+//errors print
+#define USAGE_ERROR "usage: sudukuclient <socket path> <filename> [requests] [connections]\n"
+#define FILE_NOT_FOUND "FILE_IS_NOT_FOUND\n"
+#define CONNECT_ERROR "sudukuclient: can not connect to %s\n"
+#define SUMMARY "%ld requests, %d failed, %.3f s, %.0f requests/s\n" \
+				"latency us: p50 %ld p90 %ld p99 %ld max %ld\n"
+
+/**
+ * @def struct Connection
+ * @brief the work of one load test connection and the latency of each of its requests
+ */
+typedef struct Connection
+{
+	const char* socketPath;
+	const char* request;
+	uint32_t requestLength;
+	int requests;
+	int print;
+	int failed;
+	long* latencies;
+} Connection;
+
+//-------------------------------------------functions----------------------------------------------
+/**
+ * @def nowMicro
+ * @brief monotonic time in microseconds
+ */
+static long nowMicro(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * MICRO_IN_SEC + now.tv_nsec / NANO_IN_MICRO;
+}
+
+/**
+ * @def connectTo
+ * @brief connect to the server socket
+ * @return the connected socket, INVALID_COMMAND on failure
+ */
+static int connectTo(const char* path)
+{
+	struct sockaddr_un address;
+	if(strlen(path) >= sizeof(address.sun_path))
+	{
+		return INVALID_COMMAND;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0)
+	{
+		return INVALID_COMMAND;
+	}
+	if(connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0)
+	{
+		close(fd);
+		return INVALID_COMMAND;
+	}
+	return fd;
+}
+
+/**
+ * @def readFile
+ * @brief read the whole file into memory
+ * @param length - set to the file length
+ * @return the allocated file text, NULL on failure
+ */
+static char* readFile(const char* fileName, uint32_t* length)
+{
+	FILE* file = fopen(fileName, "rb");
+	if(file == NULL)
+	{
+		return NULL;
+	}
+	char* text = (char*)malloc(MAX_MESSAGE_SIZE);
+	if(text != NULL)
+	{
+		*length = (uint32_t)fread(text, 1, MAX_MESSAGE_SIZE, file);
+	}
+	fclose(file);
+	return text;
+}
+
+/**
+ * @def runConnection
+ * @brief thread of one connection - send the requests and time each response
+ */
+static void* runConnection(void* arg)
+{
+	Connection* connection = (Connection*)arg;
+	char* response = NULL;
+	size_t capacity = 0;
+	uint32_t length;
+	long start;
+	int index;
+
+	int fd = connectTo(connection->socketPath);
+	if(fd == INVALID_COMMAND)
+	{
+		fprintf(stderr, CONNECT_ERROR, connection->socketPath);
+		connection->failed = connection->requests;
+		return NULL;
+	}
+
+	for(index = 0; index < connection->requests; index++)
+	{
+		start = nowMicro();
+		if(!sendMessage(fd, connection->request, connection->requestLength) || \
+		   !receiveMessage(fd, &response, &capacity, &length))
+		{
+			connection->failed = connection->requests - index;
+			break;
+		}
+		connection->latencies[index] = nowMicro() - start;
+		if(connection->print)
+		{
+			fwrite(response, 1, length, stdout);
+		}
+	}
+
+	close(fd);
+	free(response);
+	return NULL;
+}
+
+/**
+ * @def compareLatency
+ * @brief qsort compare of two latencies
+ */
+static int compareLatency(const void* a, const void* b)
+{
+	long first = *(const long*)a, second = *(const long*)b;
+	return (first > second) - (first < second);
+}
+
+/**
+ * @def numberArgument
+ * @brief read the number of an argument
+ * @param const char* text - the argument
+ * @param int min, max - the valid range of the number (min is not negative)
+ * @return the number, INVALID_COMMAND if the text is not a whole number in range
+ */
+static int numberArgument(const char* text, int min, int max)
+{
+	char* end;
+	long number = strtol(text, &end, 10);
+	if(end == text || *end != '\0' || number < min || number > max)
+	{
+		return INVALID_COMMAND;
+	}
+	return (int)number;
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc <= FILE_NAME || argc > CONNECTIONS + 1)
+	{
+		printf(USAGE_ERROR);
+		return INVALID_COMMAND;
+	}
+	int requests = argc > REQUESTS ? numberArgument(argv[REQUESTS], 1, INT_MAX) : 1;
+	int connectionsAmount = argc > CONNECTIONS ? \
+							numberArgument(argv[CONNECTIONS], 1, MAX_CONNECTIONS) : 1;
+	if(requests == INVALID_COMMAND || connectionsAmount == INVALID_COMMAND)
+	{
+		printf(USAGE_ERROR);
+		return INVALID_COMMAND;
+	}
+
+	uint32_t requestLength;
+	char* request = readFile(argv[FILE_NAME], &requestLength);
+	if(request == NULL)
+	{
+		printf(FILE_NOT_FOUND);
+		return INVALID_COMMAND;
+	}
+
+	long total = (long)requests * connectionsAmount;
+	long* latencies = (long*)calloc(total, sizeof(long));
+	Connection* connections = (Connection*)calloc(connectionsAmount, sizeof(Connection));
+	pthread_t* threads = (pthread_t*)calloc(connectionsAmount, sizeof(pthread_t));
+	if(latencies == NULL || connections == NULL || threads == NULL)
+	{
+		//allocation failed
+		free(latencies);
+		free(connections);
+		free(threads);
+		free(request);
+		return INVALID_COMMAND;
+	}
+
+	int index, failed = 0;
+	long start = nowMicro();
+	for(index = 0; index < connectionsAmount; index++)
+	{
+		connections[index].socketPath = argv[SOCKET_PATH];
+		connections[index].request = request;
+		connections[index].requestLength = requestLength;
+		connections[index].requests = requests;
+		connections[index].print = (total == 1);
+		connections[index].latencies = latencies + (long)index * requests;
+		if(pthread_create(&threads[index], NULL, runConnection, &connections[index]) != 0)
+		{
+			connections[index].failed = requests;
+			threads[index] = pthread_self();
+		}
+	}
+	for(index = 0; index < connectionsAmount; index++)
+	{
+		if(!pthread_equal(threads[index], pthread_self()))
+		{
+			pthread_join(threads[index], NULL);
+		}
+		failed += connections[index].failed;
+	}
+	long elapsed = nowMicro() - start;
+
+	if(total > 1)
+	{
+		// failed requests have zero latency, sort them out of the percentiles
+		qsort(latencies, total, sizeof(long), compareLatency);
+		long* done = latencies + failed;
+		long doneAmount = total - failed;
+		if(doneAmount > 0)
+		{
+			printf(SUMMARY, total, failed, (double)elapsed / MICRO_IN_SEC,
+				   (double)doneAmount * MICRO_IN_SEC / (elapsed ? elapsed : 1),
+				   done[doneAmount / 2], done[doneAmount * 9 / 10], done[doneAmount * 99 / 100],
+				   done[doneAmount - 1]);
+		}
+	}
+
+	free(latencies);
+	free(connections);
+	free(threads);
+	free(request);
+	return failed ? INVALID_COMMAND : 0;
+}
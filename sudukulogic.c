@@ -0,0 +1,819 @@
+/**
+ * @file sudukulogic.c
+ * @author guffi
+ *
+ * @brief This file implement the sudukulogic.h function.
+ * 		the units come from the table shape: rows 0..N-1, cols N..2N-1, sub squres (or regions)
+ * 		2N..3N-1, then the diagonals and cages. a full unit (N slots) holds every value once,
+ * 		a smaller cage only holds each value at most once.
+ */
+//-------------------------------------include------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sudukulogic.h"
+
+//------------------------------------const definitions---------------------------------------------
+/**
+ * @def MAX_SUBSET_SIZE 3
+ * @brief the largest subset (triples, swordfish) the deductions look for
+ */
+#define MAX_SUBSET_SIZE 3
+/**
+ * @def EMPTY_SLOT_VAL 0
+ * @brief the val for empty slot in the table
+ */
+#define EMPTY_SLOT_VAL 0
+
+#define TRUE 1
+#define FALSE 0
+
+/**
+ * @def struct Logic
+ * @brief the state of one deduce call
+ * 		cand - maskWords words of free values for each slot, 0 for full slots.
+ * 		sets, setIds, cover - scratch of the subset techniques.
+ * 		placed - the slots that were filled, failed - set when the table has no solution.
+ */
+typedef struct Logic
+{
+	Suduku* suduku;
+	int tableSize;
+	int unitAmount;
+	int maskWords;
+	MaskWord* cand;
+	MaskWord* sets;
+	int* setIds;
+	int* placed;
+	int placedAmount;
+	int failed;
+} Logic;
+
+/**
+ * @def struct SubsetSearch
+ * @brief one search for size sets (out of amount) whose union has exactly size values. found is
+ * 		called for each such subset with the chosen set indexes and their union.
+ */
+typedef struct SubsetSearch
+{
+	Logic* logic;
+	const MaskWord* sets;
+	const int* ids;
+	int amount;
+	int size;
+	int unit;
+	int val;
+	int chosen[MAX_SUBSET_SIZE];
+	MaskWord unions[MAX_SUBSET_SIZE + 1][MAX_MASK_WORDS];
+	int (*found)(struct SubsetSearch* search, const MaskWord* unionMask);
+} SubsetSearch;
+
+/**
+ * @def struct LogicStep
+ * @brief one technique of the deductions - the level it starts at, the counter of its hits and
+ * 		its function with the subset size it looks for (unused by the singles and locked)
+ */
+typedef struct LogicStep
+{
+	int level;
+	LogicTechnique technique;
+	int (*run)(Logic* logic, int size);
+	int size;
+} LogicStep;
+
+//-------------------------------------------globals------------------------------------------------
+static const char* gTechniqueNames[LOGIC_TECHNIQUES] = {"naked single", "hidden single",
+														"locked candidates", "naked pair",
+														"naked triple", "hidden pair",
+														"hidden triple", "x-wing", "swordfish"};
+
+//-------------------------------------------functions----------------------------------------------
+/**
+ * @def maskCount
+ * @brief number of values in the mask
+ */
+static int maskCount(const MaskWord* mask, int maskWords)
+{
+	int word, amount = 0;
+	for(word = 0; word < maskWords; word++)
+	{
+		amount += __builtin_popcountll(mask[word]);
+	}
+	return amount;
+}
+
+/**
+ * @def maskNext
+ * @brief the smallest value above val in the mask
+ * @return the value, EMPTY_SLOT_VAL if there is none
+ */
+static int maskNext(const MaskWord* mask, int maskWords, int val)
+{
+	int word = val / MASK_WORD_BITS;
+	MaskWord bits;
+
+	if(word >= maskWords)
+	{
+		return EMPTY_SLOT_VAL;
+	}
+	// the bits of values up to val are dropped from the first word
+	bits = mask[word] & ~(MASK_BIT(val + 1) - 1);
+	for(;;)
+	{
+		if(bits != 0)
+		{
+			return word * MASK_WORD_BITS + __builtin_ctzll(bits) + 1;
+		}
+		if(++word >= maskWords)
+		{
+			return EMPTY_SLOT_VAL;
+		}
+		bits = mask[word];
+	}
+}
+
+/**
+ * @def maskHas
+ * @brief check if val is in the mask
+ */
+static int maskHas(const MaskWord* mask, int val)
+{
+	return (mask[MASK_WORD(val)] & MASK_BIT(val)) != 0;
+}
+
+/**
+ * @def slotCand
+ * @brief the candidate mask of the given slot
+ */
+static MaskWord* slotCand(const Logic* logic, int slot)
+{
+	return logic->cand + slot * logic->maskWords;
+}
+
+/**
+ * @def inUnit
+ * @brief check if the slot belongs to the unit
+ */
+static int inUnit(const Logic* logic, int slot, int unit)
+{
+	const int* units;
+	int amount = getSlotUnits(logic->suduku, slot, &units), index;
+	for(index = 0; index < amount; index++)
+	{
+		if(units[index] == unit)
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * @def isEmpty
+ * @brief check if the slot is still empty
+ */
+static int isEmpty(const Logic* logic, int slot)
+{
+	return getSlotValue(logic->suduku, slot) == EMPTY_SLOT_VAL;
+}
+
+/**
+ * @def eliminate
+ * @brief remove val from the candidates of the slot
+ * @return 1 if val was a candidate, otherwise 0
+ */
+static int eliminate(Logic* logic, int slot, int val)
+{
+	MaskWord* cand = slotCand(logic, slot);
+	if(!maskHas(cand, val))
+	{
+		return 0;
+	}
+	cand[MASK_WORD(val)] &= ~MASK_BIT(val);
+	return 1;
+}
+
+/**
+ * @def place
+ * @brief put val in the slot and remove it from the candidates of the slot units
+ * @return False if val can not be put there - the table has no solution
+ */
+static int place(Logic* logic, int slot, int val)
+{
+	MaskWord allowed[MAX_MASK_WORDS];
+	const int* units;
+	const int* slots;
+	int unitAmount, unit, size, i, word;
+
+	if(!setSlotValue(logic->suduku, slot, val))
+	{
+		logic->failed = TRUE;
+		return FALSE;
+	}
+	if(logic->placed != NULL)
+	{
+		logic->placed[logic->placedAmount] = slot;
+	}
+	logic->placedAmount++;
+
+	memset(slotCand(logic, slot), 0, logic->maskWords * sizeof(MaskWord));
+	unitAmount = getSlotUnits(logic->suduku, slot, &units);
+	for(unit = 0; unit < unitAmount; unit++)
+	{
+		size = getUnitSlots(logic->suduku, units[unit], &slots);
+		for(i = 0; i < size; i++)
+		{
+			eliminate(logic, slots[i], val);
+			// the sum left for a cage shrinks too - take the values it still allows
+			if(getUnitSum(logic->suduku, units[unit]) != 0 && isEmpty(logic, slots[i]))
+			{
+				getSlotCandidates(logic->suduku, slots[i], allowed);
+				for(word = 0; word < logic->maskWords; word++)
+				{
+					slotCand(logic, slots[i])[word] &= allowed[word];
+				}
+			}
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * @def nakedSingles
+ * @brief fill each empty slot that has only one candidate
+ * @param subsetSize - not used, all the techniques share the LogicStep signature
+ * @return the number of filled slots
+ */
+static int nakedSingles(Logic* logic, int subsetSize)
+{
+	int slot, amount, hits = 0;
+	(void)subsetSize;
+	for(slot = 0; slot < logic->tableSize * logic->tableSize && !logic->failed; slot++)
+	{
+		if(!isEmpty(logic, slot))
+		{
+			continue;
+		}
+		amount = maskCount(slotCand(logic, slot), logic->maskWords);
+		if(amount == 0)
+		{
+			logic->failed = TRUE;
+		}
+		else if(amount == 1 && place(logic, slot, maskNext(slotCand(logic, slot), \
+															 logic->maskWords, 0)))
+		{
+			hits++;
+		}
+	}
+	return hits;
+}
+
+/**
+ * @def hiddenSingles
+ * @brief fill each value that has only one place left in some unit
+ * @param subsetSize - not used, all the techniques share the LogicStep signature
+ * @return the number of filled slots
+ */
+static int hiddenSingles(Logic* logic, int subsetSize)
+{
+	MaskWord once[MAX_MASK_WORDS], twice[MAX_MASK_WORDS], present[MAX_MASK_WORDS];
+	int unit, i, word, val, slot = 0, hits = 0;
+	int maskWords = logic->maskWords;
+	const int* slots;
+	(void)subsetSize;
+
+	for(unit = 0; unit < logic->unitAmount && !logic->failed; unit++)
+	{
+		// only a full unit must hold every value
+		if(getUnitSlots(logic->suduku, unit, &slots) != logic->tableSize)
+		{
+			continue;
+		}
+		memset(once, 0, sizeof(once));
+		memset(twice, 0, sizeof(twice));
+		memset(present, 0, sizeof(present));
+		for(i = 0; i < logic->tableSize; i++)
+		{
+			slot = slots[i];
+			val = getSlotValue(logic->suduku, slot);
+			if(val != EMPTY_SLOT_VAL)
+			{
+				present[MASK_WORD(val)] |= MASK_BIT(val);
+				continue;
+			}
+			for(word = 0; word < maskWords; word++)
+			{
+				twice[word] |= once[word] & slotCand(logic, slot)[word];
+				once[word] |= slotCand(logic, slot)[word];
+			}
+		}
+		for(word = 0; word < maskWords; word++)
+		{
+			// a value that is neither in the unit nor a candidate of it has no place
+			MaskWord all = (word == maskWords - 1 && logic->tableSize % MASK_WORD_BITS) ? \
+						   MASK_BIT(logic->tableSize + 1) - 1 : ~0ULL;
+			if(all & ~(present[word] | once[word]))
+			{
+				logic->failed = TRUE;
+				return hits;
+			}
+			once[word] &= ~twice[word];
+		}
+		for(val = maskNext(once, maskWords, 0); val != EMPTY_SLOT_VAL; \
+			val = maskNext(once, maskWords, val))
+		{
+			// the place of val may be gone by a value placed before in this loop
+			for(i = 0; i < logic->tableSize; i++)
+			{
+				slot = slots[i];
+				if(maskHas(slotCand(logic, slot), val))
+				{
+					break;
+				}
+			}
+			if(i == logic->tableSize || !place(logic, slot, val))
+			{
+				logic->failed = TRUE;
+				return hits;
+			}
+			hits++;
+		}
+	}
+	return hits;
+}
+
+/**
+ * @def lockedCandidates
+ * @brief when all the places of a value in a full unit are in some other unit too, the value is
+ * 		removed from the rest of that other unit - pointing (sub squre to line), box/line
+ * 		reduction (line to sub squre) and the same for regions, diagonals and cages.
+ * @param subsetSize - not used, all the techniques share the LogicStep signature
+ * @return the number of locked values that removed candidates
+ */
+static int lockedCandidates(Logic* logic, int subsetSize)
+{
+	int common[MAX_TABLE_SIZE][MAX_SLOT_UNITS];
+	int commonAmount[MAX_TABLE_SIZE];
+	const int* slots;
+	const int* units;
+	const int* otherSlots;
+	int unit, i, val, index, kept, amount, other, size, removed, hits = 0;
+	(void)subsetSize;
+
+	for(unit = 0; unit < logic->unitAmount; unit++)
+	{
+		if(getUnitSlots(logic->suduku, unit, &slots) != logic->tableSize)
+		{
+			continue;
+		}
+		// the units shared by all the places of each value, -1 before its first place
+		for(val = 0; val < logic->tableSize; val++)
+		{
+			commonAmount[val] = -1;
+		}
+		for(i = 0; i < logic->tableSize; i++)
+		{
+			MaskWord* cand = slotCand(logic, slots[i]);
+			amount = getSlotUnits(logic->suduku, slots[i], &units);
+			for(val = maskNext(cand, logic->maskWords, 0); val != EMPTY_SLOT_VAL; \
+				val = maskNext(cand, logic->maskWords, val))
+			{
+				int* shared = common[val - 1];
+				if(commonAmount[val - 1] == -1)
+				{
+					for(index = 0, kept = 0; index < amount; index++)
+					{
+						if(units[index] != unit)
+						{
+							shared[kept++] = units[index];
+						}
+					}
+					commonAmount[val - 1] = kept;
+					continue;
+				}
+				for(index = 0, kept = 0; index < commonAmount[val - 1]; index++)
+				{
+					for(other = 0; other < amount && units[other] != shared[index]; other++);
+					if(other < amount)
+					{
+						shared[kept++] = shared[index];
+					}
+				}
+				commonAmount[val - 1] = kept;
+			}
+		}
+
+		for(val = 1; val <= logic->tableSize; val++)
+		{
+			for(index = 0; index < commonAmount[val - 1]; index++)
+			{
+				size = getUnitSlots(logic->suduku, common[val - 1][index], &otherSlots);
+				removed = 0;
+				for(i = 0; i < size; i++)
+				{
+					if(!inUnit(logic, otherSlots[i], unit))
+					{
+						removed += eliminate(logic, otherSlots[i], val);
+					}
+				}
+				hits += removed ? 1 : 0;
+			}
+		}
+	}
+	return hits;
+}
+
+/**
+ * @def searchSubsets
+ * @brief recursively choose sets from index start on, keeping the union of the chosen sets
+ * @return the hits of the found subsets
+ */
+static int searchSubsets(SubsetSearch* search, int start, int depth)
+{
+	int index, word, hits = 0;
+	int maskWords = search->logic->maskWords;
+
+	if(depth == search->size)
+	{
+		if(maskCount(search->unions[depth], maskWords) == search->size)
+		{
+			return search->found(search, search->unions[depth]);
+		}
+		return 0;
+	}
+	for(index = start; index <= search->amount - (search->size - depth); index++)
+	{
+		search->chosen[depth] = index;
+		for(word = 0; word < maskWords; word++)
+		{
+			search->unions[depth + 1][word] = search->unions[depth][word] | \
+											  search->sets[index * maskWords + word];
+		}
+		// the union only grows - stop as soon as it is too big
+		if(maskCount(search->unions[depth + 1], maskWords) <= search->size)
+		{
+			hits += searchSubsets(search, index + 1, depth + 1);
+		}
+	}
+	return hits;
+}
+
+/**
+ * @def runSubsets
+ * @brief find all the subsets of the given size in sets
+ * @return the hits of the found subsets
+ */
+static int runSubsets(SubsetSearch* search)
+{
+	if(search->amount < search->size)
+	{
+		return 0;
+	}
+	memset(search->unions[0], 0, sizeof(search->unions[0]));
+	return searchSubsets(search, 0, 0);
+}
+
+/**
+ * @def isChosen
+ * @brief check if the id belongs to one of the chosen sets
+ */
+static int isChosen(const SubsetSearch* search, int id)
+{
+	int index;
+	for(index = 0; index < search->size; index++)
+	{
+		if(search->ids[search->chosen[index]] == id)
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * @def nakedFound
+ * @brief size slots of a unit share size values - remove them from the other slots of the unit
+ */
+static int nakedFound(SubsetSearch* search, const MaskWord* unionMask)
+{
+	Logic* logic = search->logic;
+	const int* slots;
+	int size = getUnitSlots(logic->suduku, search->unit, &slots);
+	int i, slot, val, removed = 0;
+
+	for(i = 0; i < size; i++)
+	{
+		slot = slots[i];
+		if(isChosen(search, slot))
+		{
+			continue;
+		}
+		for(val = maskNext(unionMask, logic->maskWords, 0); val != EMPTY_SLOT_VAL; \
+			val = maskNext(unionMask, logic->maskWords, val))
+		{
+			removed += eliminate(logic, slot, val);
+		}
+	}
+	return removed ? 1 : 0;
+}
+
+/**
+ * @def hiddenFound
+ * @brief size values of a unit have only size places - remove the other values from them
+ */
+static int hiddenFound(SubsetSearch* search, const MaskWord* unionMask)
+{
+	Logic* logic = search->logic;
+	MaskWord keep[MAX_MASK_WORDS];
+	const int* slots;
+	int index, word, i, removed = 0;
+
+	getUnitSlots(logic->suduku, search->unit, &slots);
+	memset(keep, 0, sizeof(keep));
+	for(index = 0; index < search->size; index++)
+	{
+		int val = search->ids[search->chosen[index]];
+		keep[MASK_WORD(val)] |= MASK_BIT(val);
+	}
+	// the union holds places in the unit (place i is bit of value i + 1)
+	for(i = maskNext(unionMask, logic->maskWords, 0); i != EMPTY_SLOT_VAL; \
+		i = maskNext(unionMask, logic->maskWords, i))
+	{
+		MaskWord* cand = slotCand(logic, slots[i - 1]);
+		for(word = 0; word < logic->maskWords; word++)
+		{
+			removed += (cand[word] & ~keep[word]) != 0;
+			cand[word] &= keep[word];
+		}
+	}
+	return removed ? 1 : 0;
+}
+
+/**
+ * @def fishFound
+ * @brief val has places only in size cover lines along size base lines - remove val from the
+ * 		other slots of the cover lines. search->unit is 0 for rows base, 1 for cols base
+ */
+static int fishFound(SubsetSearch* search, const MaskWord* unionMask)
+{
+	Logic* logic = search->logic;
+	int cover, base, removed = 0;
+
+	for(cover = maskNext(unionMask, logic->maskWords, 0); cover != EMPTY_SLOT_VAL; \
+		cover = maskNext(unionMask, logic->maskWords, cover))
+	{
+		for(base = 0; base < logic->tableSize; base++)
+		{
+			if(!isChosen(search, base))
+			{
+				removed += eliminate(logic, search->unit ? (cover - 1) * logic->tableSize + base : \
+									 base * logic->tableSize + cover - 1, search->val);
+			}
+		}
+	}
+	return removed ? 1 : 0;
+}
+
+/**
+ * @def nakedSubsets
+ * @brief naked pairs (size 2) or triples (size 3) in every unit
+ * @return the number of subsets that removed candidates
+ */
+static int nakedSubsets(Logic* logic, int size)
+{
+	SubsetSearch search;
+	const int* slots;
+	int unit, i, slot, amount, unitSize, hits = 0;
+
+	search.logic = logic;
+	search.sets = logic->sets;
+	search.ids = logic->setIds;
+	search.size = size;
+	search.found = nakedFound;
+	for(unit = 0; unit < logic->unitAmount; unit++)
+	{
+		search.unit = unit;
+		search.amount = 0;
+		unitSize = getUnitSlots(logic->suduku, unit, &slots);
+		for(i = 0; i < unitSize; i++)
+		{
+			slot = slots[i];
+			amount = maskCount(slotCand(logic, slot), logic->maskWords);
+			if(amount >= 2 && amount <= size)
+			{
+				memcpy(logic->sets + search.amount * logic->maskWords, slotCand(logic, slot), \
+					   logic->maskWords * sizeof(MaskWord));
+				logic->setIds[search.amount++] = slot;
+			}
+		}
+		hits += runSubsets(&search);
+	}
+	return hits;
+}
+
+/**
+ * @def hiddenSubsets
+ * @brief hidden pairs (size 2) or triples (size 3) in every unit
+ * @return the number of subsets that removed candidates
+ */
+static int hiddenSubsets(Logic* logic, int size)
+{
+	SubsetSearch search;
+	const int* slots;
+	int unit, i, val, amount, hits = 0;
+	int maskWords = logic->maskWords;
+
+	search.logic = logic;
+	search.sets = logic->sets;
+	search.ids = logic->setIds;
+	search.size = size;
+	search.found = hiddenFound;
+	for(unit = 0; unit < logic->unitAmount; unit++)
+	{
+		// only in a full unit every value needs a place
+		if(getUnitSlots(logic->suduku, unit, &slots) != logic->tableSize)
+		{
+			continue;
+		}
+		search.unit = unit;
+		// the places of each value in the unit, as mask over the unit slots
+		memset(logic->sets, 0, logic->tableSize * maskWords * sizeof(MaskWord));
+		for(i = 0; i < logic->tableSize; i++)
+		{
+			MaskWord* cand = slotCand(logic, slots[i]);
+			for(val = maskNext(cand, maskWords, 0); val != EMPTY_SLOT_VAL; \
+				val = maskNext(cand, maskWords, val))
+			{
+				logic->sets[(val - 1) * maskWords + MASK_WORD(i + 1)] |= MASK_BIT(i + 1);
+			}
+		}
+		// keep the values with 2..size places, packed to the front
+		search.amount = 0;
+		for(val = 1; val <= logic->tableSize; val++)
+		{
+			amount = maskCount(logic->sets + (val - 1) * maskWords, maskWords);
+			if(amount >= 2 && amount <= size)
+			{
+				memmove(logic->sets + search.amount * maskWords, \
+						logic->sets + (val - 1) * maskWords, maskWords * sizeof(MaskWord));
+				logic->setIds[search.amount++] = val;
+			}
+		}
+		hits += runSubsets(&search);
+	}
+	return hits;
+}
+
+/**
+ * @def fish
+ * @brief X-wing (size 2) or swordfish (size 3) for every value, with rows and then cols as base
+ * @return the number of fish that removed candidates
+ */
+static int fish(Logic* logic, int size)
+{
+	SubsetSearch search;
+	int orientation, val, base, cover, slot, amount, hits = 0;
+	int maskWords = logic->maskWords;
+
+	search.logic = logic;
+	search.sets = logic->sets;
+	search.ids = logic->setIds;
+	search.size = size;
+	search.found = fishFound;
+	for(orientation = 0; orientation < 2; orientation++)
+	{
+		search.unit = orientation;
+		for(val = 1; val <= logic->tableSize; val++)
+		{
+			search.val = val;
+			search.amount = 0;
+			for(base = 0; base < logic->tableSize; base++)
+			{
+				// the cover lines where val may go along this base line
+				MaskWord* set = logic->sets + search.amount * maskWords;
+				memset(set, 0, maskWords * sizeof(MaskWord));
+				for(cover = 0; cover < logic->tableSize; cover++)
+				{
+					slot = orientation ? cover * logic->tableSize + base : \
+						   base * logic->tableSize + cover;
+					if(maskHas(slotCand(logic, slot), val))
+					{
+						set[MASK_WORD(cover + 1)] |= MASK_BIT(cover + 1);
+					}
+				}
+				amount = maskCount(set, maskWords);
+				if(amount >= 2 && amount <= size)
+				{
+					logic->setIds[search.amount++] = base;
+				}
+			}
+			hits += runSubsets(&search);
+		}
+	}
+	return hits;
+}
+
+/**
+ * @def gSteps
+ * @brief the techniques from the cheapest - after any progress deduce starts again from the first
+ */
+static const LogicStep gSteps[] = {{LOGIC_SINGLES, LOGIC_NAKED_SINGLE, nakedSingles, 1},
+								   {LOGIC_SINGLES, LOGIC_HIDDEN_SINGLE, hiddenSingles, 1},
+								   {LOGIC_LOCKED, LOGIC_LOCKED_CANDIDATES, lockedCandidates, 1},
+								   {LOGIC_SUBSETS, LOGIC_NAKED_PAIR, nakedSubsets, 2},
+								   {LOGIC_SUBSETS, LOGIC_HIDDEN_PAIR, hiddenSubsets, 2},
+								   {LOGIC_SUBSETS, LOGIC_NAKED_TRIPLE, nakedSubsets, 3},
+								   {LOGIC_SUBSETS, LOGIC_HIDDEN_TRIPLE, hiddenSubsets, 3},
+								   {LOGIC_FISH, LOGIC_X_WING, fish, 2},
+								   {LOGIC_FISH, LOGIC_SWORDFISH, fish, 3}};
+
+/**
+ * @overload sudukulogic.h
+ */
+size_t deduceBytes(const Suduku* suduku)
+{
+	int tableSize = suduku->tableSize;
+	return (tableSize * tableSize + tableSize) * suduku->maskWords * sizeof(MaskWord) + \
+		   tableSize * sizeof(int);
+}
+
+/**
+ * @overload sudukulogic.h
+ */
+const char* logicTechniqueName(int technique)
+{
+	return gTechniqueNames[technique];
+}
+
+/**
+ * @overload sudukulogic.h
+ */
+int deduce(Suduku* suduku, int level, unsigned long* hits, MaskWord* scratch, int* placed,
+		   int* placedAmount)
+{
+	Logic logic;
+	int tableSize = suduku->tableSize, slot, step, found;
+
+	if(placedAmount != NULL)
+	{
+		*placedAmount = 0;
+	}
+	if(level <= LOGIC_NONE)
+	{
+		return TRUE;
+	}
+
+	logic.suduku = suduku;
+	logic.tableSize = tableSize;
+	logic.unitAmount = getUnitAmount(suduku);
+	logic.maskWords = suduku->maskWords;
+	logic.placed = placed;
+	logic.placedAmount = 0;
+	logic.failed = FALSE;
+	logic.cand = scratch != NULL ? scratch : (MaskWord*)malloc(deduceBytes(suduku));
+	if(logic.cand == NULL)
+	{
+		//allocation failed - no deductions, the search still finds the solution
+		return TRUE;
+	}
+	logic.sets = logic.cand + tableSize * tableSize * logic.maskWords;
+	logic.setIds = (int*)(logic.sets + tableSize * logic.maskWords);
+
+	for(slot = 0; slot < tableSize * tableSize; slot++)
+	{
+		if(isEmpty(&logic, slot))
+		{
+			getSlotCandidates(suduku, slot, slotCand(&logic, slot));
+		}
+		else
+		{
+			memset(slotCand(&logic, slot), 0, logic.maskWords * sizeof(MaskWord));
+		}
+	}
+
+	// after any progress start again from the cheapest technique
+	do
+	{
+		found = 0;
+		for(step = 0; step < (int)(sizeof(gSteps) / sizeof(gSteps[0])) && level >= gSteps[step].level; \
+			step++)
+		{
+			found = gSteps[step].run(&logic, gSteps[step].size);
+			if(found != 0 || logic.failed)
+			{
+				hits[gSteps[step].technique] += found;
+				break;
+			}
+		}
+	} while(found != 0 && !logic.failed);
+
+	if(logic.cand != scratch)
+	{
+		free(logic.cand);
+	}
+	if(placedAmount != NULL)
+	{
+		*placedAmount = logic.placedAmount;
+	}
+	return !logic.failed;
+}
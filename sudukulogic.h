@@ -0,0 +1,75 @@
+/**
+ * @file sudukulogic.h
+ * @author guffi
+ *
+ * @brief The header file of sudukulogic - human style deductions that run between search steps.
+ * 		they work on the candidate masks of the empty slots and place every value they force,
+ * 		so the search has less to branch on.
+ */
+#ifndef SUDUKULOGIC_H
+#define SUDUKULOGIC_H
+
+#include "sudukutree.h"
+
+/**
+ * @def LOGIC_NONE 0
+ * @brief deduction level - no deductions, plain search
+ */
+#define LOGIC_NONE 0
+/**
+ * @def LOGIC_SINGLES 1
+ * @brief deduction level - naked and hidden singles
+ */
+#define LOGIC_SINGLES 1
+/**
+ * @def LOGIC_LOCKED 2
+ * @brief deduction level - singles and locked candidates (pointing and box/line reduction)
+ */
+#define LOGIC_LOCKED 2
+/**
+ * @def LOGIC_SUBSETS 3
+ * @brief deduction level - all the above and naked / hidden pairs and triples
+ */
+#define LOGIC_SUBSETS 3
+/**
+ * @def LOGIC_FISH 4
+ * @brief deduction level - all the above and X-wing and swordfish
+ */
+#define LOGIC_FISH 4
+
+/**
+ * @def deduce
+ * @brief run the deductions of the given level until none of them makes progress. each forced
+ * 		value is put in the table with setSlotValue.
+ * @param Suduku* suduku - the suduku node, with no pending slot (as in getNodeChildren)
+ * @param int level - the deduction level (LOGIC_NONE to LOGIC_FISH)
+ * @param unsigned long* hits - LOGIC_TECHNIQUES counters, one is added each time a technique
+ * 		places a value or removes candidates
+ * @param MaskWord* scratch - deduceBytes of memory to work in, kept by the caller from call to
+ * 		call so deduce does not allocate. NULL to allocate its own
+ * @param int* placed - gets the index of every slot that was filled, may be NULL. it has room
+ * 		for all the empty slots of the table
+ * @param int* placedAmount - gets the number of filled slots, may be NULL
+ * @return False if the table has no solution (some slot or value has no place left), otherwise
+ * 		True. in both cases placed holds the slots that were filled.
+ */
+int deduce(Suduku* suduku, int level, unsigned long* hits, MaskWord* scratch, int* placed,
+		   int* placedAmount);
+
+/**
+ * @def deduceBytes
+ * @brief the memory one deduce call uses for the given table
+ * @param Suduku* suduku - the suduku node
+ * @return the bytes deduce allocates (or takes as scratch)
+ */
+size_t deduceBytes(const Suduku* suduku);
+
+/**
+ * @def logicTechniqueName
+ * @brief the name of the technique for reports
+ * @param int technique - LogicTechnique value
+ * @return the technique name
+ */
+const char* logicTechniqueName(int technique);
+
+#endif
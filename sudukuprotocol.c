@@ -0,0 +1,108 @@
+/**
+ * @file sudukuprotocol.c
+ * @author guffi
+ * 
+ * @brief This file implement the sudukuprotocol.h function. 
+ */
+//-------------------------------------include------------------------------------------------------
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include "sudukuprotocol.h"
+
+//-------------------------------------------functions----------------------------------------------
+/**
+ * @def writeAll
+ * @brief write all the bytes, retrying short writes
+ * @return 1 on success, 0 if the connection failed
+ */
+static int writeAll(int fd, const char* data, size_t length)
+{
+	ssize_t written;
+	while(length > 0)
+	{
+		written = write(fd, data, length);
+		if(written < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(written <= 0)
+		{
+			return 0;
+		}
+		data += written;
+		length -= written;
+	}
+	return 1;
+}
+
+/**
+ * @def readAll
+ * @brief read exactly length bytes, retrying short reads
+ * @return 1 on success, 0 if the connection was closed or failed
+ */
+static int readAll(int fd, char* data, size_t length)
+{
+	ssize_t got;
+	while(length > 0)
+	{
+		got = read(fd, data, length);
+		if(got < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(got <= 0)
+		{
+			return 0;
+		}
+		data += got;
+		length -= got;
+	}
+	return 1;
+}
+
+/**
+ * @overload sudukuprotocol.h
+ */
+int sendMessage(int fd, const char* data, uint32_t length)
+{
+	uint32_t header = htonl(length);
+	return writeAll(fd, (const char*)&header, sizeof(header)) && writeAll(fd, data, length);
+}
+
+/**
+ * @overload sudukuprotocol.h
+ */
+int receiveMessage(int fd, char** buffer, size_t* capacity, uint32_t* length)
+{
+	uint32_t header;
+	if(!readAll(fd, (char*)&header, sizeof(header)))
+	{
+		return 0;
+	}
+	*length = ntohl(header);
+	if(*length > MAX_MESSAGE_SIZE)
+	{
+		return 0;
+	}
+	
+	if(*buffer == NULL || *capacity < (size_t)*length + 1)
+	{
+		char* grown = (char*)realloc(*buffer, (size_t)*length + 1);
+		if(grown == NULL)
+		{
+			//allocation failed
+			return 0;
+		}
+		*buffer = grown;
+		*capacity = (size_t)*length + 1;
+	}
+	
+	if(!readAll(fd, *buffer, *length))
+	{
+		return 0;
+	}
+	(*buffer)[*length] = '\0';
+	return 1;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file sudukuprotocol.h
+ * @author guffi
+ * 
+ * @brief The header file of sudukuprotocol - the messages between sudukuserver and its clients.
+ * 		each message is 4 bytes length (network byte order) followed by that many bytes of text.
+ * 		a request holds a suduku file, the response holds what sudukusolver prints for it.
+ * 		a connection may send any number of requests, each is answered in order.
+ */ 
+#ifndef SUDUKUPROTOCOL_H
+#define SUDUKUPROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @def MAX_MESSAGE_SIZE
+ * @brief the longest message accepted - a 225x225 table with three digit values fits easily
+ */
+#define MAX_MESSAGE_SIZE (1 << 20)
+
+/**
+ * @def sendMessage
+ * @brief send one message
+ * @param int fd - the connected socket
+ * @param const char* data - the message text
+ * @param uint32_t length - the message length
+ * @return 1 on success, 0 if the connection failed
+ */
+int sendMessage(int fd, const char* data, uint32_t length);
+
+/**
+ * @def receiveMessage
+ * @brief receive one message into a buffer that is grown when needed and reused between calls
+ * @param int fd - the connected socket
+ * @param char** buffer - the buffer (may point to NULL), a '\0' is added after the message
+ * @param size_t* capacity - the buffer size
+ * @param uint32_t* length - the message length
+ * @return 1 on success, 0 if the connection was closed, failed or the message is too long
+ */
+int receiveMessage(int fd, char** buffer, size_t* capacity, uint32_t* length);
+
+#endif
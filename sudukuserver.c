@@ -0,0 +1,647 @@
+/**
+ * @file sudukuserver.c
+ * @author guffi
+ *
+ * @brief The main of the suduku server - a long running solver that answers puzzles sent over a
+ * 		unix domain socket (see sudukuprotocol.h). The accepting thread polls the idle
+ * 		connections and hands each one that has a request to a pool of worker threads - a worker
+ * 		answers one request and gives the connection back, so idle clients do not hold workers.
+ * 		Each worker keeps its request and response buffers between requests so a warm server
+ * 		only pays for parsing and solving.
+ */
+//-------------------------------------include------------------------------------------------------
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "sudukusolve.h"
+#include "sudukuprotocol.h"
+#include "sudukutrace.h"
+
+//------------------------------------const definitions---------------------------------------------
+/**
+ * @def SOCKET_PATH 1
+ * @brief the socket path location in the givan argv[]
+ */
+#define SOCKET_PATH 1
+/**
+ * @def WORKERS 2
+ * @brief the optional workers amount location in the givan argv[]
+ */
+#define WORKERS 2
+/**
+ * @def PORTFOLIO 3
+ * @brief the optional portfolio size location in the givan argv[] - each request is searched
+ * 		with this many branch orders at once, with restarts (see SolveConfig)
+ */
+#define PORTFOLIO 3
+/**
+ * @def TRACE_FORMAT 4
+ * @brief the optional trace format location in the givan argv[] - "prometheus" or "json". the
+ * 		phases of each request are timed, and their histograms are printed to stderr on SIGUSR1
+ * 		and when the server stops (see sudukutrace.h)
+ */
+#define TRACE_FORMAT 4
+/**
+ * @def MAX_PORTFOLIO 64
+ * @brief max portfolio size
+ */
+#define MAX_PORTFOLIO 64
+/**
+ * @def DEFAULT_WORKERS 4
+ * @brief the workers amount when it is not given
+ */
+#define DEFAULT_WORKERS 4
+/**
+ * @def MAX_WORKERS 256
+ * @brief max workers amount
+ */
+#define MAX_WORKERS 256
+/**
+ * @def CONNECTION_QUEUE_SIZE 128
+ * @brief max connections that wait to be accepted
+ */
+#define CONNECTION_QUEUE_SIZE 128
+/**
+ * @def MAX_CONNECTIONS 1024
+ * @brief max open connections, idle or served - no more are accepted until one closes
+ */
+#define MAX_CONNECTIONS 1024
+/**
+ * @def REQUEST_TIMEOUT 5
+ * @brief seconds a worker waits for the rest of a request (or for the client to take the
+ * 		response) before it drops the connection
+ */
+#define REQUEST_TIMEOUT 5
+/**
+ * @def WAKE_FD 0
+ * @brief the index of the wake pipe in the polled fds of the accepting thread
+ */
+#define WAKE_FD 0
+/**
+ * @def LISTEN_FD 1
+ * @brief the index of the server socket in the polled fds, the idle connections come after it
+ */
+#define LISTEN_FD 1
+/**
+ * @def REQUEST_NAME "request"
+ * @brief the file name used in the not valid file message of a request
+ */
+#define REQUEST_NAME "request"
+/**
+ * @def INVALID_COMMAND -1
+ * @brief value for all invalid command
+ */
+#define INVALID_COMMAND -1
+
+#define TRUE 1
+#define FALSE 0
+
+//errors print
+#define USAGE_ERROR "usage: sudukuserver <socket path> [workers] [portfolio] [trace format]\n"
+#define SOCKET_ERROR "sudukuserver: can not listen on %s\n"
+
+/**
+ * @def struct ConnectionQueue
+ * @brief the connections between the acceptor and the workers. fds is the queue of connections
+ * 		with a request, the acceptor pushes and the workers pop. returned holds the connections
+ * 		the workers answered, for the acceptor to poll again, and dropped counts the ones they
+ * 		closed. active holds the connection each worker serves, so stopping can shut them down.
+ * 		every connection is in one place at a time, so none of the arrays can be full.
+ */
+typedef struct ConnectionQueue
+{
+	int fds[MAX_CONNECTIONS];
+	int returned[MAX_CONNECTIONS];
+	int active[MAX_WORKERS];
+	int head;
+	int size;
+	int returnedSize;
+	int dropped;
+	int closed;
+	pthread_mutex_t lock;
+	pthread_cond_t notEmpty;
+} ConnectionQueue;
+
+//-------------------------------------------globals------------------------------------------------
+static ConnectionQueue gQueue = {{0}, {0}, {0}, 0, 0, 0, 0, FALSE, PTHREAD_MUTEX_INITIALIZER,
+								 PTHREAD_COND_INITIALIZER};
+static volatile sig_atomic_t gStop = FALSE;
+static volatile sig_atomic_t gDump = FALSE;
+/**
+ * @def gWakePipe
+ * @brief the signal handlers and the workers that give a connection back write a byte to it, so
+ * 		the accepting thread wakes up from poll
+ */
+static int gWakePipe[2] = {INVALID_COMMAND, INVALID_COMMAND};
+static SolveConfig gConfig = {ENGINE_DFS, 0, 0, FALSE, SEARCH_DFS};
+
+//-------------------------------------------functions----------------------------------------------
+/**
+ * @def wakeAcceptor
+ * @brief wake the accepting thread from poll (called after the flag or the queue it has to look
+ * 		at is set, also by the signal handlers) - when the pipe is full it is awake already
+ */
+static void wakeAcceptor(void)
+{
+	int savedErrno = errno;
+	ssize_t written = write(gWakePipe[1], "", 1);
+	(void)written;
+	errno = savedErrno;
+}
+
+/**
+ * @def stopHandler
+ * @brief SIGINT / SIGTERM handler - stop accepting and let the workers finish
+ */
+static void stopHandler(int signum)
+{
+	(void)signum;
+	gStop = TRUE;
+	wakeAcceptor();
+}
+
+/**
+ * @def dumpHandler
+ * @brief SIGUSR1 handler - the accepting thread prints the trace histograms
+ */
+static void dumpHandler(int signum)
+{
+	(void)signum;
+	gDump = TRUE;
+	wakeAcceptor();
+}
+
+/**
+ * @def wakePipe
+ * @brief create the wake pipe, both ends non blocking
+ * @return False on failure
+ */
+static int wakePipe(void)
+{
+	int end;
+	if(pipe(gWakePipe) < 0)
+	{
+		return FALSE;
+	}
+	for(end = 0; end < 2; end++)
+	{
+		if(fcntl(gWakePipe[end], F_SETFL, fcntl(gWakePipe[end], F_GETFL) | O_NONBLOCK) < 0)
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * @def drainWakePipe
+ * @brief read all the bytes written to the wake pipe - the flags and the queue tell what they
+ * 		were for
+ */
+static void drainWakePipe(void)
+{
+	char bytes[64];
+	while(read(gWakePipe[0], bytes, sizeof(bytes)) > 0)
+	{
+	}
+}
+
+/**
+ * @def queuePush
+ * @brief add connection that has a request (never waits - the queue has room for all of them)
+ * @return False if the queue was closed
+ */
+static int queuePush(ConnectionQueue* queue, int fd)
+{
+	pthread_mutex_lock(&queue->lock);
+	if(queue->closed)
+	{
+		pthread_mutex_unlock(&queue->lock);
+		return FALSE;
+	}
+	queue->fds[(queue->head + queue->size) % MAX_CONNECTIONS] = fd;
+	queue->size++;
+	pthread_cond_signal(&queue->notEmpty);
+	pthread_mutex_unlock(&queue->lock);
+	return TRUE;
+}
+
+/**
+ * @def queuePop
+ * @brief take the oldest connection, waits while the queue is empty
+ * @param int workerIndex - the worker that will serve the connection
+ * @return the connection, INVALID_COMMAND once the queue is closed and empty
+ */
+static int queuePop(ConnectionQueue* queue, int workerIndex)
+{
+	int fd = INVALID_COMMAND;
+	pthread_mutex_lock(&queue->lock);
+	while(queue->size == 0 && !queue->closed)
+	{
+		pthread_cond_wait(&queue->notEmpty, &queue->lock);
+	}
+	if(queue->size > 0)
+	{
+		fd = queue->fds[queue->head];
+		queue->head = (queue->head + 1) % MAX_CONNECTIONS;
+		queue->size--;
+		queue->active[workerIndex] = fd;
+	}
+	pthread_mutex_unlock(&queue->lock);
+	return fd;
+}
+
+/**
+ * @def queueDone
+ * @brief the worker is done with its connection - give it back to the acceptor to wait for the
+ * 		next request, or close it (under the queue lock, so stopping never shuts down a reused fd)
+ * @param int workerIndex - the worker that served the connection
+ * @param int keep - False to close the connection
+ */
+static void queueDone(ConnectionQueue* queue, int workerIndex, int keep)
+{
+	pthread_mutex_lock(&queue->lock);
+	int fd = queue->active[workerIndex];
+	queue->active[workerIndex] = INVALID_COMMAND;
+	if(keep && !queue->closed)
+	{
+		queue->returned[queue->returnedSize++] = fd;
+	}
+	else
+	{
+		close(fd);
+		queue->dropped++;
+	}
+	pthread_mutex_unlock(&queue->lock);
+	wakeAcceptor();
+}
+
+/**
+ * @def queueTakeReturned
+ * @brief move the connections the workers gave back to the polled fds of the acceptor
+ * @param struct pollfd* polled - where to add them
+ * @param int* dropped - gets the number of connections the workers closed since the last call
+ * @return the number of connections added
+ */
+static int queueTakeReturned(ConnectionQueue* queue, struct pollfd* polled, int* dropped)
+{
+	int index, taken;
+	pthread_mutex_lock(&queue->lock);
+	for(index = 0; index < queue->returnedSize; index++)
+	{
+		polled[index].fd = queue->returned[index];
+		polled[index].events = POLLIN;
+		polled[index].revents = 0;
+	}
+	taken = queue->returnedSize;
+	queue->returnedSize = 0;
+	*dropped = queue->dropped;
+	queue->dropped = 0;
+	pthread_mutex_unlock(&queue->lock);
+	return taken;
+}
+
+/**
+ * @def queueClose
+ * @brief wake all the workers and shut down the connections they serve, they exit when the 
+ * 		queue is empty
+ */
+static void queueClose(ConnectionQueue* queue)
+{
+	int index;
+	pthread_mutex_lock(&queue->lock);
+	queue->closed = TRUE;
+	for(index = 0; index < MAX_WORKERS; index++)
+	{
+		if(queue->active[index] != INVALID_COMMAND)
+		{
+			shutdown(queue->active[index], SHUT_RDWR);
+		}
+	}
+	// connections that no worker took yet or that were not polled again are dropped
+	for(; queue->size > 0; queue->size--)
+	{
+		close(queue->fds[queue->head]);
+		queue->head = (queue->head + 1) % MAX_CONNECTIONS;
+	}
+	for(; queue->returnedSize > 0; queue->returnedSize--)
+	{
+		close(queue->returned[queue->returnedSize - 1]);
+	}
+	pthread_cond_broadcast(&queue->notEmpty);
+	pthread_mutex_unlock(&queue->lock);
+}
+
+/**
+ * @def answerRequest
+ * @brief parse and solve one request, the response is what sudukusolver prints for it
+ * @param const char* request - the request text
+ * @param uint32_t length - the request length
+ * @param FILE* out - the memory stream of the worker, the response replaces what it held
+ * @return False if the response could not be written
+ */
+static int answerRequest(char* request, uint32_t length, FILE* out)
+{
+	rewind(out);
+	FILE* in = length ? fmemopen(request, length, "r") : NULL;
+	Suduku* sudukuTable = NULL;
+	long start = traceStart();
+	if(in == NULL)
+	{
+		fprintf(out, NOT_VALID_FILE, REQUEST_NAME);
+	}
+	else
+	{
+		sudukuTable = parser(in, REQUEST_NAME, out);
+		fclose(in);
+	}
+	traceRecord(TRACE_PARSE, sudukuTable != NULL ? sudukuTable->tableSize : 0, &gConfig, start);
+
+	if(sudukuTable != NULL)
+	{
+		solveSuduku(sudukuTable, &gConfig, NULL, out);
+	}
+	// the memory stream sets the response to what was written since the rewind
+	return fflush(out) == 0 && !ferror(out);
+}
+
+/**
+ * @def worker
+ * @brief worker thread - answers one request of each connection it takes, until the server
+ * 		stops. the request buffer and the response stream (with its buffer) belong to the worker
+ * 		and are reused by all its requests - the table itself is parsed and freed per request.
+ */
+static void* worker(void* arg)
+{
+	int workerIndex = (int)(size_t)arg;
+	char* request = NULL;
+	size_t capacity = 0;
+	uint32_t length;
+	char* response = NULL;
+	size_t responseLength = 0;
+	FILE* out = open_memstream(&response, &responseLength);
+	int fd, keep;
+
+	if(out == NULL)
+	{
+		//allocation failed - the connections given to this worker are closed unanswered
+		fprintf(stderr, "allocation failed\n");
+	}
+	while((fd = queuePop(&gQueue, workerIndex)) != INVALID_COMMAND)
+	{
+		keep = out != NULL && receiveMessage(fd, &request, &capacity, &length) && \
+			   answerRequest(request, length, out) && \
+			   sendMessage(fd, response, (uint32_t)responseLength);
+		queueDone(&gQueue, workerIndex, keep);
+	}
+
+	if(out != NULL)
+	{
+		fclose(out);
+	}
+	free(response);
+	free(request);
+	return NULL;
+}
+
+/**
+ * @def connectionTimeout
+ * @brief limit the time a worker waits on a connection in the middle of a request or a response
+ * @return False on failure
+ */
+static int connectionTimeout(int fd)
+{
+	struct timeval timeout = {REQUEST_TIMEOUT, 0};
+	return setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0 && \
+		   setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) == 0;
+}
+
+/**
+ * @def listenOn
+ * @brief create the non blocking server socket on the given path (an old socket file is
+ * 		replaced)
+ * @return the socket, INVALID_COMMAND on failure
+ */
+static int listenOn(const char* path)
+{
+	struct sockaddr_un address;
+	if(strlen(path) >= sizeof(address.sun_path))
+	{
+		return INVALID_COMMAND;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0)
+	{
+		return INVALID_COMMAND;
+	}
+	unlink(path);
+	// non blocking, so a connection that goes away between poll and accept does not hold the
+	// accepting thread
+	if(bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0 || \
+	   listen(fd, CONNECTION_QUEUE_SIZE) < 0 || fcntl(fd, F_SETFL, O_NONBLOCK) < 0)
+	{
+		close(fd);
+		return INVALID_COMMAND;
+	}
+	return fd;
+}
+
+/**
+ * @def numberArgument
+ * @brief read the number of an argument
+ * @param const char* text - the argument
+ * @param int min, max - the valid range of the number (min is not negative)
+ * @return the number, INVALID_COMMAND if the text is not a whole number in range
+ */
+static int numberArgument(const char* text, int min, int max)
+{
+	char* end;
+	long number = strtol(text, &end, 10);
+	if(end == text || *end != '\0' || number < min || number > max)
+	{
+		return INVALID_COMMAND;
+	}
+	return (int)number;
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < WORKERS || argc > TRACE_FORMAT + 1)
+	{
+		printf(USAGE_ERROR);
+		return INVALID_COMMAND;
+	}
+
+	int workersAmount = argc > WORKERS ? numberArgument(argv[WORKERS], 1, MAX_WORKERS) : \
+						DEFAULT_WORKERS;
+	if(workersAmount == INVALID_COMMAND)
+	{
+		printf(USAGE_ERROR);
+		return INVALID_COMMAND;
+	}
+	gConfig.portfolio = argc > PORTFOLIO ? numberArgument(argv[PORTFOLIO], 0, MAX_PORTFOLIO) : 0;
+	if(gConfig.portfolio == INVALID_COMMAND)
+	{
+		printf(USAGE_ERROR);
+		return INVALID_COMMAND;
+	}
+	gConfig.restarts = gConfig.portfolio > 0;
+	int traceOption = argc > TRACE_FORMAT ? traceFormat(argv[TRACE_FORMAT]) : INVALID_COMMAND;
+	if(argc > TRACE_FORMAT && traceOption == INVALID_COMMAND)
+	{
+		printf(USAGE_ERROR);
+		return INVALID_COMMAND;
+	}
+	if(traceOption != INVALID_COMMAND)
+	{
+		traceEnable();
+	}
+
+	int listenFd = listenOn(argv[SOCKET_PATH]);
+	if(listenFd == INVALID_COMMAND || !wakePipe())
+	{
+		fprintf(stderr, SOCKET_ERROR, argv[SOCKET_PATH]);
+		return INVALID_COMMAND;
+	}
+
+	// the handlers wake the accepting thread through the wake pipe - a signal that comes
+	// between the check of its flag and poll still ends the poll
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = stopHandler;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	action.sa_handler = dumpHandler;
+	sigaction(SIGUSR1, &action, NULL);
+	// a client that goes away must not kill the server
+	signal(SIGPIPE, SIG_IGN);
+
+	// the workers block the stop and dump signals so they are delivered to the accepting thread
+	sigset_t stopSignals, oldMask;
+	sigemptyset(&stopSignals);
+	sigaddset(&stopSignals, SIGINT);
+	sigaddset(&stopSignals, SIGTERM);
+	sigaddset(&stopSignals, SIGUSR1);
+	pthread_sigmask(SIG_BLOCK, &stopSignals, &oldMask);
+
+	pthread_t workers[MAX_WORKERS];
+	int index;
+	for(index = 0; index < MAX_WORKERS; index++)
+	{
+		gQueue.active[index] = INVALID_COMMAND;
+	}
+	for(index = 0; index < workersAmount; index++)
+	{
+		if(pthread_create(&workers[index], NULL, worker, (void*)(size_t)index) != 0)
+		{
+			workersAmount = index;
+			break;
+		}
+	}
+	pthread_sigmask(SIG_SETMASK, &oldMask, NULL);
+
+	// the polled fds - the wake pipe, the server socket and then the idle connections
+	static struct pollfd polled[LISTEN_FD + 1 + MAX_CONNECTIONS];
+	int idle = 0, connections = 0, dropped, fd;
+	polled[WAKE_FD].fd = gWakePipe[0];
+	polled[WAKE_FD].events = POLLIN;
+	polled[LISTEN_FD].events = POLLIN;
+	while(!gStop && workersAmount > 0)
+	{
+		if(gDump)
+		{
+			gDump = FALSE;
+			if(traceOption != INVALID_COMMAND)
+			{
+				traceDump(stderr, (TraceFormat)traceOption);
+			}
+		}
+		idle += queueTakeReturned(&gQueue, polled + LISTEN_FD + 1 + idle, &dropped);
+		connections -= dropped;
+		// no more connections are accepted until one of them closes (poll skips a negative fd)
+		polled[LISTEN_FD].fd = connections < MAX_CONNECTIONS ? listenFd : INVALID_COMMAND;
+		if(poll(polled, LISTEN_FD + 1 + idle, -1) < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			break;
+		}
+		if(polled[WAKE_FD].revents & POLLIN)
+		{
+			drainWakePipe();
+		}
+		// the connections with a request (or that hung up) go to the workers
+		for(index = LISTEN_FD + 1; index < LISTEN_FD + 1 + idle; )
+		{
+			if(polled[index].revents == 0)
+			{
+				index++;
+				continue;
+			}
+			if(!queuePush(&gQueue, polled[index].fd))
+			{
+				close(polled[index].fd);
+				connections--;
+			}
+			polled[index] = polled[LISTEN_FD + idle];
+			idle--;
+		}
+		if(!(polled[LISTEN_FD].revents & POLLIN))
+		{
+			continue;
+		}
+		fd = accept(listenFd, NULL, NULL);
+		if(fd < 0)
+		{
+			if(errno == EINTR || errno == ECONNABORTED || errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				continue;
+			}
+			break;
+		}
+		if(!connectionTimeout(fd))
+		{
+			close(fd);
+			continue;
+		}
+		polled[LISTEN_FD + 1 + idle].fd = fd;
+		polled[LISTEN_FD + 1 + idle].events = POLLIN;
+		polled[LISTEN_FD + 1 + idle].revents = 0;
+		idle++;
+		connections++;
+	}
+
+	// the wake pipe stays open - a late signal still has somewhere to write
+	close(listenFd);
+	for(index = LISTEN_FD + 1; index < LISTEN_FD + 1 + idle; index++)
+	{
+		close(polled[index].fd);
+	}
+	queueClose(&gQueue);
+	for(index = 0; index < workersAmount; index++)
+	{
+		pthread_join(workers[index], NULL);
+	}
+	unlink(argv[SOCKET_PATH]);
+	if(traceOption != INVALID_COMMAND)
+	{
+		traceDump(stderr, (TraceFormat)traceOption);
+	}
+	return 0;
+}
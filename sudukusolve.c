@@ -0,0 +1,588 @@
+/**
+ * @file sudukusolve.c
+ * @author guffi
+ * 
+ * @brief This file implement the sudukusolve.h function. 
+ */
+//-------------------------------------include------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "genericdfs.h"
+#include "sudukulogic.h"
+#include "sudukusolve.h"
+#include "sudukutrace.h"
+
+//------------------------------------const definitions---------------------------------------------
+/**
+ * @def TABLE_SIZE_FORMAT "%d\n"
+ * @brief the table size line format in the given file 
+ */
+#define TABLE_SIZE_FORMAT "%d\n"
+/**
+ * @def SECTION_FORMAT " %15s"
+ * @brief the name of a variant section after the table
+ */
+#define SECTION_FORMAT " %15s"
+#define REGIONS_SECTION "regions"
+#define DIAGONALS_SECTION "diagonals"
+#define CAGES_SECTION "cages"
+/**
+ * @def INVALID_COMMAND -1
+ * @brief value for all invalid command
+ */
+#define INVALID_COMMAND -1
+/**
+ * @def TABLE(N, row, col) ((N * row) + col)
+ * @brief How to access the cell structure of the table
+ */
+#define TABLE(N, row, col) ((N * row) + col)
+/**
+ * @def PORTFOLIO_WARMUP 2000
+ * @brief nodes the plain branch order gets on its own before the portfolio threads start - easy
+ * 		tables never pay for the threads
+ */
+#define PORTFOLIO_WARMUP 2000
+/**
+ * @def LUBY_UNIT 100
+ * @brief node budget of one step of the Luby restart sequence (1, 1, 2, 1, 1, 2, 4, ...)
+ */
+#define LUBY_UNIT 100
+/**
+ * @def BEAM_WIDTH 64
+ * @brief the nodes of each level SEARCH_BEAM keeps
+ */
+#define BEAM_WIDTH 64
+
+#define TRUE 1
+#define FALSE 0
+#define NEW_LINE '\n'
+#define SPACE ' ' 
+
+/**
+ * @def struct PortfolioMember
+ * @brief one thread of the portfolio - it searches copies of table with the seeds index + 1,
+ * 		index + 1 + members, index + 1 + 2 * members ... until it finishes or stop is set. won is set for
+ * 		the member that finished first, with its solution (NULL for no solution) and stats.
+ */
+typedef struct PortfolioMember
+{
+	const Suduku* table;
+	const SolveConfig* config;
+	int index;
+	int members;
+	atomic_int* stop;
+	pthread_t thread;
+	int started;
+	int won;
+	Suduku* solution;
+	SolveStats stats;
+} PortfolioMember;
+//-------------------------------------------functions----------------------------------------------
+/**
+ * @overload sudukusolve.h
+ */
+void solutionPrinter(FILE* out, const Suduku* sudukuTable)
+{
+	int colIndex, rowIndex;
+	fprintf(out, "%d\n", sudukuTable->tableSize);
+	for(rowIndex = 0; rowIndex < sudukuTable->tableSize; rowIndex++)
+	{
+		for(colIndex = 0; colIndex < sudukuTable->tableSize; colIndex++)
+		{
+			fprintf(out, "%d", getSlotValue(sudukuTable, \
+									  TABLE(sudukuTable->tableSize, rowIndex, colIndex)));
+			
+			if(colIndex == sudukuTable->tableSize - 1)
+			{
+				fputc(NEW_LINE, out);
+			}
+			else
+			{
+				fputc(SPACE, out);
+			}
+		}
+	} 
+}
+
+/**
+ * @def readNumbers
+ * @brief read amount whitespace separated numbers
+ * @return False if the file has less numbers
+ */
+static int readNumbers(FILE* currentFile, int* numbers, int amount)
+{
+	int index;
+	for(index = 0; index < amount; index++)
+	{
+		if(fscanf(currentFile, "%d", &numbers[index]) != 1)
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * @def markUnit
+ * @brief add the value to the occupancy bitmask of one unit
+ * @param MaskWord* unit - the unit bitmask
+ * @return False if the value is already in the unit
+ */
+static int markUnit(MaskWord* unit, int val)
+{
+	if(unit[MASK_WORD(val)] & MASK_BIT(val))
+	{
+		return FALSE;
+	}
+	unit[MASK_WORD(val)] |= MASK_BIT(val);
+	return TRUE;
+}
+
+/**
+ * @def readSections
+ * @brief read the variant sections after the table (see parser)
+ * @param SudukuVariant* variant - filled with the sections, its arrays point into numbers
+ * @param int* numbers - room for 3 * tableSize * tableSize numbers
+ * @return False if some section is not valid
+ */
+static int readSections(FILE* currentFile, int tableSize, SudukuVariant* variant, int* numbers)
+{
+	char section[16];
+	int slots = tableSize * tableSize;
+	
+	while(fscanf(currentFile, SECTION_FORMAT, section) == 1)
+	{
+		if(strcmp(section, REGIONS_SECTION) == 0 && variant->regions == NULL)
+		{
+			if(!readNumbers(currentFile, numbers, slots))
+			{
+				return FALSE;
+			}
+			variant->regions = numbers;
+		}
+		else if(strcmp(section, DIAGONALS_SECTION) == 0 && !variant->diagonals)
+		{
+			variant->diagonals = TRUE;
+		}
+		else if(strcmp(section, CAGES_SECTION) == 0 && variant->cages == NULL)
+		{
+			// every slot may be a cage of its own
+			if(fscanf(currentFile, "%d", &variant->cageAmount) != 1 || \
+			   variant->cageAmount <= 0 || variant->cageAmount > slots || \
+			   !readNumbers(currentFile, numbers + slots, slots) || \
+			   !readNumbers(currentFile, numbers + 2 * slots, variant->cageAmount))
+			{
+				return FALSE;
+			}
+			variant->cages = numbers + slots;
+			variant->cageSums = numbers + 2 * slots;
+		}
+		else
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * @overload sudukusolve.h
+ */
+void* parser(FILE* currentFile, const char* fileName, FILE* out)
+{
+	int tableSize;
+	
+	if(fscanf(currentFile, TABLE_SIZE_FORMAT, &tableSize) != 1 || tableSize <= 0 || \
+	   tableSize > MAX_TABLE_SIZE)
+	{ 
+		fprintf(out, NOT_VALID_FILE, fileName);
+		return NULL;
+	}
+	
+	// the table is made after the sections that follow the values, so the values are kept until
+	// then. rows and cols are units of every table and are checked as each slot is read, sub
+	// squres too but their conflict counts only if no regions section replaces them. the
+	// regions, diagonals and cages are checked when the values are set on the table.
+	int slots = tableSize * tableSize;
+	int words = MASK_WORDS(tableSize);
+	int* numbers = (int*)malloc(4 * slots * sizeof(int));
+	MaskWord* rows = (MaskWord*)calloc(3 * tableSize * words, sizeof(MaskWord));
+	if(numbers == NULL || rows == NULL)
+	{
+		//allocation failed
+		printf("allocation failed\n");
+		free(numbers);
+		free(rows);
+		return NULL;
+	}
+	int* values = numbers + 3 * slots;
+	MaskWord* cols = rows + tableSize * words;
+	MaskWord* subSqures = cols + tableSize * words;
+	int sqrt = findSqrt(tableSize);
+	int subSqureConflict = FALSE;
+	
+	int tableIndex = 0;
+	int val, row, col;
+	char nextChar;
+	
+	while(tableIndex < slots && fscanf(currentFile, "%d", &val) == 1)
+	{	
+		// check valid structre of the file
+		nextChar = fgetc(currentFile);
+	
+		if((tableIndex + 1) % tableSize == 0)
+		{
+			if(nextChar != NEW_LINE && nextChar != EOF)
+			{
+				break;
+			}
+		}
+		else
+		{
+			if(nextChar != SPACE)
+			{
+				break;
+			}
+		}
+		
+		if(val < 0 || val > tableSize)
+		{	
+			break;
+		}
+		// validation check for the slot - the value must not repeat in its row or col
+		row = tableIndex / tableSize;
+		col = tableIndex % tableSize;
+		if(val != 0)
+		{
+			if(!markUnit(rows + row * words, val) || !markUnit(cols + col * words, val))
+			{
+				break;
+			}
+			if(sqrt != INVALID_COMMAND && \
+			   !markUnit(subSqures + ((row / sqrt) * sqrt + col / sqrt) * words, val))
+			{
+				subSqureConflict = TRUE;
+			}
+		}
+		values[tableIndex++] = val;
+	}
+	
+	SudukuVariant variant = {NULL, FALSE, 0, NULL, NULL};
+	Suduku* sudukuTable = NULL;
+	if(tableIndex == slots && readSections(currentFile, tableSize, &variant, numbers) && \
+	   !(subSqureConflict && variant.regions == NULL))
+	{
+		// create suduko table
+		sudukuTable = createVariantTable(tableSize, &variant);
+	}
+	
+	// set the slots - only a regions, diagonals or cages unit can still reject a value
+	for(tableIndex = 0; sudukuTable != NULL && tableIndex < slots; tableIndex++)
+	{
+		if(values[tableIndex] != 0 && !setSlotValue(sudukuTable, tableIndex, values[tableIndex]))
+		{
+			freeNode(sudukuTable);
+			sudukuTable = NULL;
+		}
+	}
+	
+	free(numbers);
+	free(rows);
+	if(sudukuTable == NULL)
+	{
+		fprintf(out, NOT_VALID_FILE, fileName);
+	}
+	return sudukuTable;		
+}
+
+/**
+ * @def searchTree
+ * @brief search the suduku tree for the first full table
+ * @param Suduku* sudukuTable - the suduku table, it is freed by the function
+ * @param SearchStrategy strategy - the order to visit the tree in
+ * @return the solved table, NULL if there is no solution (or beam search missed it)
+ */
+static Suduku* searchTree(Suduku* sudukuTable, SearchStrategy strategy)
+{
+	// the value function return the number of full slot in the table we want to reach the first 
+	// full table in the tree so the best val will be equal to the (table size)*(table size)
+	unsigned int bestVal = (sudukuTable->tableSize * sudukuTable->tableSize);	
+	// suduku node is a small fixed size handle - the dfs stack keeps it inline, and its children
+	// (at most one for each value) are written straight into the dfs buffer
+	SearchOptions options = {strategy, {0}, BEAM_WIDTH, 0, sizeof(Suduku), clearNode, getNodeRank,
+							 getNodeChildrenInto, sudukuTable->tableSize};
+	sudukuTable = searchBest(sudukuTable, getNodeChildren, getNodeVal, freeNode, copyNode, bestVal,
+							 &options);
+	
+	//check that best suduku value is equal to best val if true -> perfect match ~ suduku solved! 
+	//otherwise suduku has no solution
+	if(sudukuTable == NULL || sudukuTable->fullSlots != sudukuTable->tableSize * \
+	   sudukuTable->tableSize)
+	{
+		freeNode(sudukuTable);
+		return NULL;
+	}
+	return sudukuTable;
+}
+
+/**
+ * @def searchLevel
+ * @brief the deduction level the search runs at - deepening and beam can not go without deductions
+ * 		(deepening revisits a tree too big for it, and a beam level of guesses has nothing to rank
+ * 		its nodes by), so they get LOGIC_SINGLES at least
+ */
+static int searchLevel(const SolveConfig* config)
+{
+	if(config == NULL)
+	{
+		return LOGIC_NONE;
+	}
+	if(config->logicLevel == LOGIC_NONE &&
+	   (config->strategy == SEARCH_ITERATIVE_DEEPENING || config->strategy == SEARCH_BEAM))
+	{
+		return LOGIC_SINGLES;
+	}
+	return config->logicLevel;
+}
+
+/**
+ * @def searchTable
+ * @brief search for the suduku solution with the given context
+ * @param Suduku* sudukuTable - the suduku table, it is freed by the function
+ * @param SudukuContext* context - the settings and counters of this search
+ * @return the solved table, NULL if there is no solution or the search was aborted
+ */
+static Suduku* searchTable(Suduku* sudukuTable, const SolveConfig* config, SudukuContext* context,
+						   SolveStats* stats)
+{
+	// every node of this search points to the context, it lives only until the search returns
+	sudukuTable->context = context;
+	stats->peakMemory = 0;
+	// the deductions of all the nodes work in one scratch - if it can not be allocated each
+	// deduce allocates its own
+	if(context->logicLevel > LOGIC_NONE)
+	{
+		context->logicScratch = (MaskWord*)malloc(deduceBytes(sudukuTable));
+	}
+	
+	if(config != NULL && config->engine == ENGINE_CHOICE_POINTS)
+	{
+		if(!solveChoicePoints(sudukuTable, &stats->peakMemory))
+		{
+			freeNode(sudukuTable);
+			sudukuTable = NULL;
+		}
+	}
+	else
+	{
+		sudukuTable = searchTree(sudukuTable, config != NULL ? config->strategy : SEARCH_DFS);
+	}
+	
+	free(context->logicScratch);
+	context->logicScratch = NULL;
+	memcpy(stats->logicHits, context->logicHits, sizeof(stats->logicHits));
+	stats->logicNanos = context->logicNanos;
+	if(sudukuTable != NULL)
+	{
+		sudukuTable->context = NULL;
+	}
+	return sudukuTable;
+}
+
+/**
+ * @def luby
+ * @brief the index-th (from 1) number of the Luby sequence 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, ...
+ */
+static unsigned long luby(unsigned long index)
+{
+	int power;
+	for(;;)
+	{
+		// the smallest 2^power - 1 that is not below index
+		for(power = 1; (1UL << power) - 1 < index; power++);
+		if((1UL << power) - 1 == index)
+		{
+			return 1UL << (power - 1);
+		}
+		index -= (1UL << (power - 1)) - 1;
+	}
+}
+
+/**
+ * @def portfolioMember
+ * @brief thread of one portfolio member - search until some search finishes (a solution or a
+ * 		proof that there is none), restarting with a new seed when the node budget runs out
+ */
+static void* portfolioMember(void* arg)
+{
+	PortfolioMember* member = (PortfolioMember*)arg;
+	const SolveConfig* config = member->config;
+	SudukuContext context;
+	Suduku* copy;
+	unsigned long restart;
+	int finished = FALSE;
+	
+	for(restart = 0; !finished && !atomic_load(member->stop); restart++)
+	{
+		copy = cloneNode(member->table);
+		if(copy == NULL)
+		{
+			//allocation failed
+			break;
+		}
+		// seed 0 - the plain order - already had its PORTFOLIO_WARMUP run, the members start at 1
+		memset(&context, 0, sizeof(context));
+		context.logicLevel = searchLevel(config);
+		context.seed = (unsigned int)(restart * member->members + member->index + 1);
+		context.nodeBudget = config->restarts ? luby(restart + 1) * LUBY_UNIT : 0;
+		context.stop = member->stop;
+		context.timeLogic = traceEnabled();
+		member->solution = searchTable(copy, config, &context, &member->stats);
+		// an aborted dfs may still visit a full table that was already on its stack
+		finished = member->solution != NULL || !context.aborted;
+	}
+	
+	// the first member that finished stops all the others
+	if(finished && !atomic_exchange(member->stop, TRUE))
+	{
+		member->won = TRUE;
+	}
+	else
+	{
+		freeNode(member->solution);
+		member->solution = NULL;
+	}
+	return NULL;
+}
+
+/**
+ * @def runPortfolio
+ * @brief search the table with config->portfolio members, the calling thread is the first one
+ * @return the solution of the member that finished first, NULL if there is no solution
+ */
+static Suduku* runPortfolio(Suduku* sudukuTable, const SolveConfig* config, SolveStats* stats)
+{
+	int members = config->portfolio > 1 ? config->portfolio : 1, index;
+	PortfolioMember* portfolio = (PortfolioMember*)calloc(members, sizeof(PortfolioMember));
+	Suduku* solution = NULL;
+	atomic_int stop;
+	
+	if(portfolio == NULL)
+	{
+		//allocation failed
+		printf("allocation failed\n");
+		freeNode(sudukuTable);
+		return NULL;
+	}
+	atomic_init(&stop, FALSE);
+	for(index = 0; index < members; index++)
+	{
+		portfolio[index].table = sudukuTable;
+		portfolio[index].config = config;
+		portfolio[index].index = index;
+		portfolio[index].members = members;
+		portfolio[index].stop = &stop;
+	}
+	// a member that can not start is left out
+	for(index = 1; index < members; index++)
+	{
+		portfolio[index].started = pthread_create(&portfolio[index].thread, NULL, \
+												  portfolioMember, &portfolio[index]) == 0;
+	}
+	portfolioMember(&portfolio[0]);
+	
+	for(index = 0; index < members; index++)
+	{
+		if(index > 0 && portfolio[index].started)
+		{
+			pthread_join(portfolio[index].thread, NULL);
+		}
+		if(portfolio[index].won)
+		{
+			solution = portfolio[index].solution;
+			*stats = portfolio[index].stats;
+		}
+	}
+	free(portfolio);
+	freeNode(sudukuTable);
+	return solution;
+}
+
+/**
+ * @def solveTable
+ * @brief findSolution without the tracing - the plain search, or the plain order on a small node
+ * 		budget and then the portfolio
+ */
+static Suduku* solveTable(Suduku* sudukuTable, const SolveConfig* config, SolveStats* stats)
+{
+	SudukuContext context;
+	memset(&context, 0, sizeof(context));
+	context.logicLevel = searchLevel(config);
+	context.timeLogic = traceEnabled();
+	if(config == NULL || (config->portfolio <= 1 && !config->restarts))
+	{
+		return searchTable(sudukuTable, config, &context, stats);
+	}
+	
+	// most tables are solved at once by the plain order - try it alone before the portfolio
+	Suduku* copy = cloneNode(sudukuTable);
+	if(copy == NULL)
+	{
+		//allocation failed
+		freeNode(sudukuTable);
+		return NULL;
+	}
+	context.nodeBudget = PORTFOLIO_WARMUP;
+	copy = searchTable(copy, config, &context, stats);
+	if(copy != NULL || !context.aborted)
+	{
+		freeNode(sudukuTable);
+		return copy;
+	}
+	return runPortfolio(sudukuTable, config, stats);
+}
+
+/**
+ * @overload sudukusolve.h
+ */
+Suduku* findSolution(Suduku* sudukuTable, const SolveConfig* config, SolveStats* stats)
+{
+	SolveStats localStats = {0};
+	if(stats == NULL)
+	{
+		stats = &localStats;
+	}
+	
+	int tableSize = sudukuTable->tableSize;
+	long start = traceStart();
+	sudukuTable = solveTable(sudukuTable, config, stats);
+	traceRecord(TRACE_SEARCH, tableSize, config, start);
+	if(start != 0 && config != NULL && config->logicLevel != LOGIC_NONE)
+	{
+		traceAdd(TRACE_LOGIC, tableSize, config, stats->logicNanos);
+	}
+	return sudukuTable;
+}
+
+/**
+ * @overload sudukusolve.h
+ */
+int solveSuduku(Suduku* sudukuTable, const SolveConfig* config, SolveStats* stats, FILE* out)
+{
+	int tableSize = sudukuTable->tableSize;
+	sudukuTable = findSolution(sudukuTable, config, stats);
+	long start = traceStart();
+	if(sudukuTable == NULL)
+	{
+		fputs(NO_SOLUTION, out);
+		traceRecord(TRACE_OUTPUT, tableSize, config, start);
+		return FALSE;
+	}
+	
+	solutionPrinter(out, sudukuTable);
+	freeNode(sudukuTable);
+	traceRecord(TRACE_OUTPUT, tableSize, config, start);
+	return TRUE;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file sudukusolve.h
+ * @author guffi
+ * 
+ * @brief The header file of sudukusolve - read, solve and print one suduku, shared by the command
+ * 		line solver and the server.
+ */ 
+#ifndef SUDUKUSOLVE_H
+#define SUDUKUSOLVE_H
+
+#include <stdio.h>
+#include "genericdfs.h"
+#include "sudukutree.h"
+
+//errors print
+#define FILE_NOT_FOUND "FILE_IS_NOT_FOUND\n"
+#define NOT_VALID_FILE "%s: not a valid suduku file\n"
+#define NO_SOLUTION "no solution!\n"
+
+/**
+ * @def enum SolveEngine
+ * @brief the search that solves the suduku
+ * 		ENGINE_DFS - searchBest over the suduku tree nodes.
+ * 		ENGINE_CHOICE_POINTS - solveChoicePoints, O(depth) memory with its peak reported.
+ */
+typedef enum SolveEngine
+{
+	ENGINE_DFS,
+	ENGINE_CHOICE_POINTS
+} SolveEngine;
+
+/**
+ * @def struct SolveConfig
+ * @brief how to solve a suduku - the search engine and the deduction level (LOGIC_NONE to
+ * 		LOGIC_FISH, see sudukulogic.h) used between its steps.
+ * 		portfolio - number of branch orders searched at once, each on its own thread (0 or 1
+ * 			for one). the first to finish wins, so a table with more than one solution may get
+ * 			another solution than the plain search.
+ * 		restarts - each branch order gives up after a Luby sequence node budget and starts again
+ * 			with a new seed.
+ * 		strategy - the order ENGINE_DFS visits the tree in (SEARCH_DFS for the plain search). beam
+ * 			keeps only the best nodes of each level, so it may miss a solution that exists.
+ * 			deepening and beam always run with LOGIC_SINGLES at least.
+ */
+typedef struct SolveConfig
+{
+	SolveEngine engine;
+	int logicLevel;
+	int portfolio;
+	int restarts;
+	SearchStrategy strategy;
+} SolveConfig;
+
+/**
+ * @def struct SolveStats
+ * @brief what one solve measured - peakMemory in bytes (ENGINE_CHOICE_POINTS only, 0 otherwise),
+ * 		how many times each deduction technique made progress and the time of the deductions in
+ * 		nanoseconds (only while tracing, see sudukutrace.h)
+ */
+typedef struct SolveStats
+{
+	size_t peakMemory;
+	unsigned long logicHits[LOGIC_TECHNIQUES];
+	unsigned long logicNanos;
+} SolveStats;
+
+/**
+ * @def solutionPrinter
+ * @brief print the suduku solution table
+ * @param FILE* out - where to print
+ * @param Suduku* sudukuTable - the suduku table
+ */
+void solutionPrinter(FILE* out, const Suduku* sudukuTable);
+
+/**
+ * @def parser
+ * @brief parser the given suduku file, each slot is validated as it is stored. the table may be
+ * 		followed by variant sections, each starts with its name:
+ * 		regions - N lines of N region numbers (1..N) that replace the sub squres (jigsaw).
+ * 		diagonals - both main diagonals hold each value once (X-suduku).
+ * 		cages <amount> - N lines of N cage numbers (1..amount, 0 for none), then the sum of
+ * 			each cage (0 for no sum) - the values of a cage do not repeat (killer).
+ * @param FILE* in - the open suduku file
+ * @param const char* fileName - the file name for the error message
+ * @param FILE* out - where to print the error message
+ * @return the suduku table, NULL if the file is not a valid suduku file
+ */
+void* parser(FILE* in, const char* fileName, FILE* out);
+
+/**
+ * @def findSolution
+ * @brief search for the suduku solution
+ * @param Suduku* sudukuTable - the suduku table, it is freed by the function
+ * @param SolveConfig* config - how to solve, NULL for ENGINE_DFS
+ * @param SolveStats* stats - filled with what the solve measured, may be NULL
+ * @return the solved table, NULL if there is no solution
+ */
+Suduku* findSolution(Suduku* sudukuTable, const SolveConfig* config, SolveStats* stats);
+
+/**
+ * @def solveSuduku
+ * @brief search for the suduku solution and print it (or that there is no solution)
+ * @param Suduku* sudukuTable - the suduku table, it is freed by the function
+ * @param SolveConfig* config - how to solve, NULL for ENGINE_DFS
+ * @param SolveStats* stats - filled with what the solve measured, may be NULL
+ * @param FILE* out - where to print
+ * @return True if the suduku was solved otherwise False
+ */
+int solveSuduku(Suduku* sudukuTable, const SolveConfig* config, SolveStats* stats, FILE* out);
+
+#endif
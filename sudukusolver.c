@@ -8,86 +8,62 @@
 //-------------------------------------include------------------------------------------------------
 #include <stdio.h>
 #include <stdlib.h>
-#include "genericdfs.h"
-#include "sudukutree.h"
+#include <string.h>
+#include <unistd.h>
+#include "sudukusolve.h"
+#include "sudukubatch.h"
+#include "sudukulogic.h"
+#include "sudukutrace.h"
 
 //------------------------------------const definitions---------------------------------------------
 /**
- * @def VALID_RECEIEVED_ARGS_NUM 2
- * @brief the valid number of args in the command
+ * @def OPTIONS "b:l:mp:rs:t:"
+ * @brief the command options:
+ * 		-b <workers> - batch, solve all the given files with this many solver threads.
+ * 		-l <level> - deductions between search steps (LOGIC_NONE to LOGIC_FISH), the hits of
+ * 			each technique are printed to stderr.
+ * 		-m - bounded memory search (ENGINE_CHOICE_POINTS), its peak memory is printed to stderr.
+ * 		-p <orders> - portfolio, search this many seeded branch orders at once.
+ * 		-r - restart each branch order with a new seed on a Luby node budget.
+ * 		-s <strategy> - the order the search visits the tree in ("dfs", "best", "deepening" or
+ * 			"beam", see SearchStrategy), "dfs" by default. deepening and beam
+ * 			always deduce singles, even without -l.
+ * 		-t <format> - time the parse, search, deductions and output of each file, and print
+ * 			their histograms to stderr at the end ("prometheus" or "json", see sudukutrace.h).
  */
-#define VALID_RECEIEVED_ARGS_NUM 2
-/**
- * @def FILE_NAME 1
- * @brief the file name location in the givan argv[]
- */
-#define FILE_NAME 1
-/**
- * @def TABLE_SIZE_FORMAT "%d\n"
- * @brief the table size line format in the given file 
- */
-#define TABLE_SIZE_FORMAT "%d\n"
+#define OPTIONS "b:l:mp:rs:t:"
 /**
  * @def INVALID_COMMAND -1
  * @brief value for all invalid command
  */
 #define INVALID_COMMAND -1
 /**
- * @def POSSIBLE_VALUE_INITIALIZE 0 
- * @brief initialize value for possiable values array 
- */
-#define POSSIBLE_VALUE_INITIALIZE 0 
-/**
- * @def TABLE(N, row, col) ((N * row) + col)
- * @brief How to access the cell structure of the table
+ * @def MAX_PORTFOLIO 64
+ * @brief max branch orders searched at once
  */
-#define TABLE(N, row, col) ((N * row) + col)
+#define MAX_PORTFOLIO 64
 
 #define TRUE 1
 #define FALSE 0
-#define NEW_LINE '\n'
-#define SPACE ' ' 
 
- 
 //errors print
-#define USAGE_ERROR "usage: sudukusolver <filename>\n"
+#define USAGE_ERROR "usage: sudukusolver [-mr] [-l <level>] [-p <orders>] [-s <strategy>] " \
+					"[-t <format>] <filename>\n" \
+					"       sudukusolver [-mr] [-l <level>] [-p <orders>] [-s <strategy>] " \
+					"[-t <format>] -b <workers> <filename>...\n"
+#define PEAK_MEMORY "peak memory: %zu bytes\n"
+#define LOGIC_HITS "%s: %lu\n"
 #define FILE_SUPPLY "please supply a file!\n"
-#define FILE_NOT_FOUND "FILE_IS_NOT_FOUND\n"
-#define NOT_VALID_FILE "%s: not a valid suduku file\n"
-#define NO_SOLUTION "no solution!\n"
+
+static const char* const STRATEGY_NAMES[SEARCH_STRATEGIES] = {"dfs", "best", "deepening", "beam"};
 //-------------------------------------------functions----------------------------------------------
 /**
- * @def solutionPrinter
- * @brief print the suduku solution table
- * @param Suduku* sudukuTable - the suduku table
- */
-void solutionPrinter(const Suduku* sudukuTable)
-{
-	int colIndex, rowIndex;
-	printf("%d\n", sudukuTable->tableSize);
-	for(rowIndex = 0; rowIndex < sudukuTable->tableSize; rowIndex++)
-	{
-		for(colIndex = 0; colIndex < sudukuTable->tableSize; colIndex++)
-		{
-			printf("%d", sudukuTable->table[TABLE(sudukuTable->tableSize, rowIndex, colIndex)]);
-			
-			if(colIndex == sudukuTable->tableSize - 1)
-			{
-				printf("%c", NEW_LINE);
-			}
-			else
-			{
-				printf("%c", SPACE);
-			}
-		}
-	} 
-}
-/**
- * @def parser
- * @brief parser the given file
+ * @def parseFile
+ * @brief open and parse the given suduku file
  * @param the file name
+ * @return the suduku table, NULL if the file is missing or not valid
  */
-void* parser(const char* fileName)
+static Suduku* parseFile(const char* fileName)
 {
 	FILE* currentFile = fopen(fileName, "r");   	
 	//check if file exist
@@ -96,202 +72,165 @@ void* parser(const char* fileName)
 		printf(FILE_NOT_FOUND);
 		return NULL;
 	}
-	int tableSize;
-	
-	if(fscanf(currentFile, TABLE_SIZE_FORMAT, &tableSize) != 1 || findSqrt(tableSize) == \
-	   INVALID_COMMAND)
-	{ 
-		fclose(currentFile);
-		printf(NOT_VALID_FILE, fileName);
-		return NULL;
-	}
-	
-	// create suduko table
-	Suduku* sudukuTable = createSudukuTable(tableSize);
-	
-	int tableIndex = 0;
-	int val;
-	char nextChar;
-	
-	while(fscanf(currentFile, "%d", &val) == 1)
-	{	
-		// check valid structre of the file
-		nextChar = fgetc(currentFile);
-	
-		if((tableIndex + 1) % tableSize == 0)
-		{
-			if(nextChar != NEW_LINE && nextChar != EOF)
-			{
-				fclose(currentFile);
-				freeNode(sudukuTable);
-				printf(NOT_VALID_FILE, fileName);
-				return NULL;
-			}
-		}
-		else
-		{
-			if(nextChar != SPACE)
-			{
-				fclose(currentFile);
-				freeNode(sudukuTable);
-				printf(NOT_VALID_FILE, fileName);
-				return NULL;
-			}
-		}
-		
-		if(val < 0 || val > tableSize)
-		{	
-			fclose(currentFile);
-			freeNode(sudukuTable);
-			printf(NOT_VALID_FILE, fileName);
-			return NULL;
-		}
-		if(val != 0)
-		{
-			sudukuTable->fullSlots ++;
-		}
-		
-		sudukuTable->table[tableIndex] = val;
-		tableIndex++;
-	
-	}
-	
-	if(tableIndex != tableSize*tableSize)
-	{
-		fclose(currentFile);
-		freeNode(sudukuTable);
-		printf(NOT_VALID_FILE, fileName);
-		return NULL;
-	}
-	
+	Suduku* sudukuTable = parser(currentFile, fileName, stdout);
 	fclose(currentFile);
-	return sudukuTable;		
-
+	return sudukuTable;
 }
+
 /**
- * @def checkReapets
- * @brief check for valid number of reaoetes in possiable value - at most one 
- * @param Suduku* sudukuTable - the suduku table
- * @param int* possibleValues - array that represent the amount of reapets of each value
- * @return False if there is to much repetition otherwise True
+ * @def numberOption
+ * @brief read the number of an option
+ * @param const char* text - the option argument
+ * @param int min, max - the valid range of the number (min is not negative)
+ * @return the number, INVALID_COMMAND if the text is not a whole number in range
  */
-int checkReapets(Suduku* sudukuTable, int* possibleValues)
+static int numberOption(const char* text, int min, int max)
 {
-	int index;
-	for(index = 0; index < sudukuTable->tableSize; index++)
-	{	
-		// Number of repetitions for each value is at most one
-		if(*(possibleValues + index) > 1)
-		{
-			free(possibleValues);
-			return FALSE;
-		}
-					//intialize the array for the next loop
-		*(possibleValues + index) = POSSIBLE_VALUE_INITIALIZE;
-	}	
-	return TRUE;
+	char* end;
+	long number = strtol(text, &end, 10);
+	if(end == text || *end != '\0' || number < min || number > max)
+	{
+		return INVALID_COMMAND;
+	}
+	return (int)number;
 }
+
 /**
- * @def checkValidation
- * @brief check that the given table is valid 
- * @param Suduku* sudukuTable the suduku table 
- * @return True if given valid otherwise False
+ * @def strategyOption
+ * @brief read the search strategy of the -s option
+ * @param const char* text - the strategy name
+ * @return the SearchStrategy, INVALID_COMMAND if there is no strategy with that name
  */
-int checkValidation(Suduku* sudukuTable)
+static int strategyOption(const char* text)
 {
-	int* possibleValues = (int*)malloc(sudukuTable->tableSize * sizeof(int));
-	if(possibleValues == NULL)
+	int strategy;
+	for(strategy = 0; strategy < SEARCH_STRATEGIES; strategy++)
 	{
-		//allocation faild
-		return 0;
+		if(strcmp(text, STRATEGY_NAMES[strategy]) == 0)
+		{
+			return strategy;
+		}
 	}
+	return INVALID_COMMAND;
+}
+
+int main(int argc, char* argv[])
+{
+	SolveConfig config = {ENGINE_DFS, LOGIC_NONE, 0, FALSE, SEARCH_DFS};
+	SolveStats stats = {0};
+	int workers = 0, traceOption = INVALID_COMMAND, option;
 	
-	int index;
-	//initalize possibleValues array 
-	for(index = 0; index < sudukuTable->tableSize; index++)
+	while((option = getopt(argc, argv, OPTIONS)) != INVALID_COMMAND)
 	{
-		*(possibleValues + index) = POSSIBLE_VALUE_INITIALIZE;
+		switch(option)
+		{
+			case 'b':
+				workers = numberOption(optarg, 1, MAX_BATCH_WORKERS);
+				if(workers == INVALID_COMMAND)
+				{
+					printf(USAGE_ERROR);
+					return INVALID_COMMAND;
+				}
+				break;
+			case 'l':
+				config.logicLevel = numberOption(optarg, LOGIC_NONE, LOGIC_FISH);
+				if(config.logicLevel == INVALID_COMMAND)
+				{
+					printf(USAGE_ERROR);
+					return INVALID_COMMAND;
+				}
+				break;
+			case 'm':
+				config.engine = ENGINE_CHOICE_POINTS;
+				break;
+			case 'p':
+				config.portfolio = numberOption(optarg, 1, MAX_PORTFOLIO);
+				if(config.portfolio == INVALID_COMMAND)
+				{
+					printf(USAGE_ERROR);
+					return INVALID_COMMAND;
+				}
+				break;
+			case 'r':
+				config.restarts = TRUE;
+				break;
+			case 's':
+				option = strategyOption(optarg);
+				if(option == INVALID_COMMAND)
+				{
+					printf(USAGE_ERROR);
+					return INVALID_COMMAND;
+				}
+				config.strategy = (SearchStrategy)option;
+				break;
+			case 't':
+				traceOption = traceFormat(optarg);
+				if(traceOption == INVALID_COMMAND)
+				{
+					printf(USAGE_ERROR);
+					return INVALID_COMMAND;
+				}
+				traceEnable();
+				break;
+			default:
+				printf(USAGE_ERROR);
+				return INVALID_COMMAND;
+		}
 	}
 	
-	SlotIndex currSlot;
-	
-	//valid Sudoku table will contain no more than one organ in each row, column or sub-square, 
-	//so we examine the diagonal and in this way we cover all the possibilities.
-	for(index = 0; index < (sudukuTable->tableSize); index++)
+	if(workers != 0)
 	{
-		currSlot.row = index;
-		currSlot.col = index;
-		//check for valid possible Values 
-		checkCol(sudukuTable, &currSlot, possibleValues);
-		if(!(checkReapets(sudukuTable, possibleValues)))
+		if(optind == argc)
 		{
-			return FALSE;
+			printf(USAGE_ERROR);
+			return INVALID_COMMAND;
 		}
-		
-		checkRow(sudukuTable, &currSlot, possibleValues);
-		if(!(checkReapets(sudukuTable, possibleValues)))
+		// runBatch prints why it failed
+		if(runBatch(argv + optind, argc - optind, workers, &config, &stats, stdout) == \
+		   INVALID_COMMAND)
 		{
-			return FALSE;
-		}
-		checksubSqure(sudukuTable, &currSlot, possibleValues);
-		if(!(checkReapets(sudukuTable, possibleValues)))
-		{
-			return FALSE;
+			return INVALID_COMMAND;
 		}
 	}
-	free(possibleValues);
-	return TRUE;
-}
-
-
-int main(int argc, char* argv[])
-{
-	
-	if(argc != VALID_RECEIEVED_ARGS_NUM)
+	else
 	{
-		printf(FILE_SUPPLY);
-		printf(USAGE_ERROR);
-		return INVALID_COMMAND;
+		if(argc - optind != 1)
+		{
+			printf(FILE_SUPPLY);
+			printf(USAGE_ERROR);
+			return INVALID_COMMAND;
+		}
+		
+		// the parser validates each slot as it stores it - no illegal repetitions
+		long start = traceStart();
+		Suduku* sudukuTable = parseFile(argv[optind]);
+		traceRecord(TRACE_PARSE, sudukuTable != NULL ? sudukuTable->tableSize : 0, &config, start);
+		//check that given suduku table is valid and exsist!
+		if(sudukuTable == NULL)
+		{
+			// a file that did not parse is still timed
+			if(traceOption != INVALID_COMMAND)
+			{
+				traceDump(stderr, (TraceFormat)traceOption);
+			}
+			return 0;
+		}
+		
+		solveSuduku(sudukuTable, &config, &stats, stdout);
 	}
 	
-	Suduku* sudukuTable = parser(argv[FILE_NAME]);
-	//check that given suduku table is valid and exsist!
-	if(sudukuTable == NULL)
+	fflush(stdout);
+	if(config.engine == ENGINE_CHOICE_POINTS)
 	{
-		return 0;
+		fprintf(stderr, PEAK_MEMORY, stats.peakMemory);
 	}
-	
-	// validation check for the given table - no illegal repetitions
-	if(!checkValidation(sudukuTable))
+	for(option = 0; config.logicLevel != LOGIC_NONE && option < LOGIC_TECHNIQUES; option++)
 	{
-		printf(NOT_VALID_FILE, argv[FILE_NAME]);
-		return 0;
+		fprintf(stderr, LOGIC_HITS, logicTechniqueName(option), stats.logicHits[option]);
 	}
-
-	// the value function return the number of full slot in the table we want to reach the first 
-	// full table in the tree so the best val will be equal to the (table size)*(table size)
-	unsigned int bestVal = (sudukuTable->tableSize * sudukuTable->tableSize);	
-	sudukuTable = getBest(sudukuTable, getNodeChildren, getNodeVal, freeNode, copyNode, bestVal);
-	
-	//check that best suduku value is equal to best val if true -> perfect match ~ suduku solved! 
-	//otherwise suduku has no solution
-	
-	if(sudukuTable == NULL || sudukuTable->fullSlots != sudukuTable->tableSize * \
-	   sudukuTable->tableSize)
+	if(traceOption != INVALID_COMMAND)
 	{
-		printf(NO_SOLUTION);
-		freeNode(sudukuTable);
-		return 0;
+		traceDump(stderr, (TraceFormat)traceOption);
 	}
-	
-	solutionPrinter(sudukuTable);
-	freeNode(sudukuTable);
 	return 0;
 }
-
-
-
-
-	
-	
-	
@@ -0,0 +1,327 @@
+/**
+ * @file sudukutrace.c
+ * @author guffi
+ *
+ * @brief This file implement the sudukutrace.h function.
+ */
+//-------------------------------------include------------------------------------------------------
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "sudukutrace.h"
+
+//------------------------------------const definitions---------------------------------------------
+/**
+ * @def TRACE_BUCKETS 26
+ * @brief buckets of each histogram - bucket i holds the times up to 2^i microseconds (1us to
+ * 		about 16s), the last one holds the rest
+ */
+#define TRACE_BUCKETS 26
+/**
+ * @def NANO_IN_SEC 1000000000
+ * @brief nanoseconds in one second
+ */
+#define NANO_IN_SEC 1000000000L
+/**
+ * @def NANO_IN_MICRO 1000
+ * @brief nanoseconds in one microsecond
+ */
+#define NANO_IN_MICRO 1000UL
+/**
+ * @def INVALID_COMMAND -1
+ * @brief value for all invalid command
+ */
+#define INVALID_COMMAND -1
+
+#define TRUE 1
+#define FALSE 0
+
+/**
+ * @def enum TraceEngine
+ * @brief the engine label of a histogram - the SolveEngine, or the portfolio that runs on top of
+ * 		the dfs
+ */
+typedef enum TraceEngine
+{
+	TRACE_ENGINE_DFS,
+	TRACE_ENGINE_CHOICE_POINTS,
+	TRACE_ENGINE_PORTFOLIO,
+	TRACE_ENGINES
+} TraceEngine;
+
+/**
+ * @def struct TraceHistogram
+ * @brief the times of one phase - the count of each bucket and their total in nanoseconds
+ */
+typedef struct TraceHistogram
+{
+	atomic_ulong buckets[TRACE_BUCKETS];
+	atomic_ulong sumNanos;
+} TraceHistogram;
+
+/**
+ * @def struct TraceSize
+ * @brief the histograms of one table size, allocated when the size is first timed
+ */
+typedef struct TraceSize
+{
+	TraceHistogram histograms[TRACE_ENGINES][TRACE_PHASES];
+} TraceSize;
+
+static const char* const PHASE_NAMES[TRACE_PHASES] = {"parse", "search", "logic", "output"};
+static const char* const ENGINE_NAMES[TRACE_ENGINES] = {"dfs", "choice_points", "portfolio"};
+
+/**
+ * @def gTraceOn
+ * @brief set once by traceEnable, before the solver threads start
+ */
+static int gTraceOn = FALSE;
+/**
+ * @def gSizes
+ * @brief the histograms of each table size, index 0 for the tables that did not parse
+ */
+static _Atomic(TraceSize*) gSizes[MAX_TABLE_SIZE + 1];
+
+//-------------------------------------------functions----------------------------------------------
+/**
+ * @overload sudukutrace.h
+ */
+int traceFormat(const char* name)
+{
+	if(strcmp(name, "prometheus") == 0)
+	{
+		return TRACE_PROMETHEUS;
+	}
+	if(strcmp(name, "json") == 0)
+	{
+		return TRACE_JSON;
+	}
+	return INVALID_COMMAND;
+}
+
+/**
+ * @overload sudukutrace.h
+ */
+void traceEnable(void)
+{
+	gTraceOn = TRUE;
+}
+
+/**
+ * @overload sudukutrace.h
+ */
+int traceEnabled(void)
+{
+	return gTraceOn;
+}
+
+/**
+ * @overload sudukutrace.h
+ */
+long traceStart(void)
+{
+	if(!gTraceOn)
+	{
+		return 0;
+	}
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * NANO_IN_SEC + now.tv_nsec;
+}
+
+/**
+ * @def traceEngine
+ * @brief the engine label of the config, as findSolution picks its search
+ */
+static int traceEngine(const SolveConfig* config)
+{
+	if(config == NULL)
+	{
+		return TRACE_ENGINE_DFS;
+	}
+	if(config->portfolio > 1 || config->restarts)
+	{
+		return TRACE_ENGINE_PORTFOLIO;
+	}
+	return config->engine == ENGINE_CHOICE_POINTS ? TRACE_ENGINE_CHOICE_POINTS : TRACE_ENGINE_DFS;
+}
+
+/**
+ * @def traceSize
+ * @brief the histograms of the table size, allocated on first use - a thread that loses the race
+ * 		to allocate them frees its own
+ * @return the histograms, NULL if allocation failed
+ */
+static TraceSize* traceSize(int tableSize)
+{
+	TraceSize* size = atomic_load_explicit(&gSizes[tableSize], memory_order_acquire);
+	if(size != NULL)
+	{
+		return size;
+	}
+
+	TraceSize* fresh = (TraceSize*)calloc(1, sizeof(TraceSize));
+	if(fresh == NULL)
+	{
+		return NULL;
+	}
+	if(!atomic_compare_exchange_strong_explicit(&gSizes[tableSize], &size, fresh, \
+												memory_order_acq_rel, memory_order_acquire))
+	{
+		free(fresh);
+		return size;
+	}
+	return fresh;
+}
+
+/**
+ * @overload sudukutrace.h
+ */
+void traceAdd(TracePhase phase, int tableSize, const SolveConfig* config, unsigned long nanos)
+{
+	if(!gTraceOn || tableSize < 0 || tableSize > MAX_TABLE_SIZE)
+	{
+		return;
+	}
+	TraceSize* size = traceSize(tableSize);
+	if(size == NULL)
+	{
+		//allocation failed - the time is lost
+		return;
+	}
+
+	// the bucket of t microseconds is ceil(log2(t)), the times above the last bound share the last.
+	// t is rounded up, so each time is at most the bound of its bucket
+	unsigned long micro = (nanos + NANO_IN_MICRO - 1) / NANO_IN_MICRO;
+	int bucket = micro <= 1 ? 0 : 64 - __builtin_clzl(micro - 1);
+	if(bucket > TRACE_BUCKETS - 1)
+	{
+		bucket = TRACE_BUCKETS - 1;
+	}
+	TraceHistogram* histogram = &size->histograms[traceEngine(config)][phase];
+	atomic_fetch_add_explicit(&histogram->buckets[bucket], 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&histogram->sumNanos, nanos, memory_order_relaxed);
+}
+
+/**
+ * @overload sudukutrace.h
+ */
+void traceRecord(TracePhase phase, int tableSize, const SolveConfig* config, long start)
+{
+	if(start == 0)
+	{
+		return;
+	}
+	long end = traceStart();
+	traceAdd(phase, tableSize, config, end > start ? (unsigned long)(end - start) : 0);
+}
+
+/**
+ * @def dumpHistogram
+ * @brief print one histogram with cumulative bucket counts
+ */
+static void dumpHistogram(FILE* out, TraceFormat format, int tableSize, int engine, int phase,
+						  const unsigned long* counts, unsigned long total, double sum, int first)
+{
+	unsigned long cumulative = 0;
+	int bucket;
+
+	if(format == TRACE_JSON)
+	{
+		fprintf(out, "%s\n    {\"phase\": \"%s\", \"size\": %d, \"engine\": \"%s\", " \
+				"\"count\": %lu, \"sum_seconds\": %.9f, \"buckets\": [", first ? "" : ",", \
+				PHASE_NAMES[phase], tableSize, ENGINE_NAMES[engine], total, sum);
+		for(bucket = 0; bucket < TRACE_BUCKETS; bucket++)
+		{
+			cumulative += counts[bucket];
+			if(bucket < TRACE_BUCKETS - 1)
+			{
+				fprintf(out, "{\"le\": %.6f, \"count\": %lu}, ", (double)(1UL << bucket) / 1e6, \
+						cumulative);
+			}
+			else
+			{
+				fprintf(out, "{\"le\": \"+Inf\", \"count\": %lu}]}", cumulative);
+			}
+		}
+		return;
+	}
+
+	for(bucket = 0; bucket < TRACE_BUCKETS; bucket++)
+	{
+		cumulative += counts[bucket];
+		fprintf(out, "suduku_phase_seconds_bucket{phase=\"%s\",size=\"%d\",engine=\"%s\",le=\"", \
+				PHASE_NAMES[phase], tableSize, ENGINE_NAMES[engine]);
+		if(bucket < TRACE_BUCKETS - 1)
+		{
+			fprintf(out, "%.6f\"} %lu\n", (double)(1UL << bucket) / 1e6, cumulative);
+		}
+		else
+		{
+			fprintf(out, "+Inf\"} %lu\n", cumulative);
+		}
+	}
+	fprintf(out, "suduku_phase_seconds_sum{phase=\"%s\",size=\"%d\",engine=\"%s\"} %.9f\n", \
+			PHASE_NAMES[phase], tableSize, ENGINE_NAMES[engine], sum);
+	fprintf(out, "suduku_phase_seconds_count{phase=\"%s\",size=\"%d\",engine=\"%s\"} %lu\n", \
+			PHASE_NAMES[phase], tableSize, ENGINE_NAMES[engine], total);
+}
+
+/**
+ * @overload sudukutrace.h
+ */
+void traceDump(FILE* out, TraceFormat format)
+{
+	unsigned long counts[TRACE_BUCKETS], total;
+	int tableSize, engine, phase, bucket, first = TRUE;
+	TraceSize* size;
+	TraceHistogram* histogram;
+
+	if(format == TRACE_JSON)
+	{
+		fprintf(out, "{\"phases\": [");
+	}
+	else
+	{
+		fprintf(out, "# HELP suduku_phase_seconds time of each solve phase by table size and " \
+				"engine\n# TYPE suduku_phase_seconds histogram\n");
+	}
+
+	for(tableSize = 0; tableSize <= MAX_TABLE_SIZE; tableSize++)
+	{
+		size = atomic_load_explicit(&gSizes[tableSize], memory_order_acquire);
+		for(engine = 0; size != NULL && engine < TRACE_ENGINES; engine++)
+		{
+			for(phase = 0; phase < TRACE_PHASES; phase++)
+			{
+				// the count is the sum of the buckets read, so the two always agree
+				histogram = &size->histograms[engine][phase];
+				total = 0;
+				for(bucket = 0; bucket < TRACE_BUCKETS; bucket++)
+				{
+					counts[bucket] = atomic_load_explicit(&histogram->buckets[bucket], \
+														  memory_order_relaxed);
+					total += counts[bucket];
+				}
+				if(total == 0)
+				{
+					continue;
+				}
+				dumpHistogram(out, format, tableSize, engine, phase, counts, total, \
+							  (double)atomic_load_explicit(&histogram->sumNanos, \
+														   memory_order_relaxed) / NANO_IN_SEC, \
+							  first);
+				first = FALSE;
+			}
+		}
+	}
+
+	if(format == TRACE_JSON)
+	{
+		fprintf(out, "\n]}\n");
+	}
+	fflush(out);
+}
@@ -0,0 +1,94 @@
+/**
+ * @file sudukutrace.h
+ * @author guffi
+ *
+ * @brief The header file of sudukutrace - latency histograms of the solve phases by table size and
+ * 		engine, for monitoring. tracing is off until traceEnable is called, and while it is off
+ * 		each phase costs one flag check.
+ */
+#ifndef SUDUKUTRACE_H
+#define SUDUKUTRACE_H
+
+#include <stdio.h>
+#include "sudukusolve.h"
+
+/**
+ * @def enum TracePhase
+ * @brief the timed phases of one solve
+ * 		TRACE_PARSE - parser, with the validation of each slot.
+ * 		TRACE_SEARCH - findSolution, with the deductions between its steps.
+ * 		TRACE_LOGIC - the deductions alone (sudukulogic), only when a logic level is set.
+ * 		TRACE_OUTPUT - printing the solution or that there is none.
+ */
+typedef enum TracePhase
+{
+	TRACE_PARSE,
+	TRACE_SEARCH,
+	TRACE_LOGIC,
+	TRACE_OUTPUT,
+	TRACE_PHASES
+} TracePhase;
+
+/**
+ * @def enum TraceFormat
+ * @brief the format of traceDump
+ */
+typedef enum TraceFormat
+{
+	TRACE_PROMETHEUS,
+	TRACE_JSON
+} TraceFormat;
+
+/**
+ * @def traceFormat
+ * @brief the dump format by its name - "prometheus" or "json"
+ * @return the TraceFormat, -1 for an unknown name
+ */
+int traceFormat(const char* name);
+
+/**
+ * @def traceEnable
+ * @brief start collecting the histograms, before any phase is timed
+ */
+void traceEnable(void);
+
+/**
+ * @def traceEnabled
+ * @brief True if the histograms are collected
+ */
+int traceEnabled(void);
+
+/**
+ * @def traceStart
+ * @brief the start time of a phase
+ * @return monotonic time in nanoseconds, 0 when tracing is off
+ */
+long traceStart(void);
+
+/**
+ * @def traceRecord
+ * @brief add the time since start to the histogram of the phase - nothing when start is 0
+ * @param TracePhase phase - the phase
+ * @param int tableSize - the table size, 0 for a table that did not parse
+ * @param SolveConfig* config - the solve config, picks the engine label (NULL for dfs)
+ * @param long start - traceStart of the phase
+ */
+void traceRecord(TracePhase phase, int tableSize, const SolveConfig* config, long start);
+
+/**
+ * @def traceAdd
+ * @brief add a measured time to the histogram of the phase - nothing when tracing is off
+ * @param unsigned long nanos - the phase time in nanoseconds
+ */
+void traceAdd(TracePhase phase, int tableSize, const SolveConfig* config, unsigned long nanos);
+
+/**
+ * @def traceDump
+ * @brief print all the histograms collected so far. may run while other threads record, each
+ * 		counter is read once.
+ * @param FILE* out - where to print
+ * @param TraceFormat format - prometheus text format or json
+ */
+void traceDump(FILE* out, TraceFormat format);
+
+#endif
@@ -5,9 +5,13 @@
  * @brief This file implement the sudukutree.h function. 
  */
 //-------------------------------------include------------------------------------------------------
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "sudukutree.h"
+#include "sudukulogic.h"
 
 //------------------------------------const definitions---------------------------------------------
 /**
@@ -31,15 +35,15 @@
  */
 #define EMPTY_SLOT_VAL 0
 /**
- * @def POSSIBLE_VALUE_INITIALIZE 0 
- * @brief initialize value for possiable values array 
+ * @def NO_PENDING_SLOT -1
+ * @brief pendingSlot value of node that has nothing to apply on its board
  */
-#define POSSIBLE_VALUE_INITIALIZE 0 
+#define NO_PENDING_SLOT -1
 /**
- * @def MAX_SQRT_VAL 10
- * @brief max possible sqrt value
+ * @def RANK_FULL_SLOT
+ * @brief the rank of one full slot - above any candidate count getNodeRank adds
  */
-#define MAX_SQRT_VAL 10
+#define RANK_FULL_SLOT ((unsigned long)MAX_SLOT_UNITS * MAX_TABLE_SIZE * MAX_TABLE_SIZE + 1)
 
 #define TRUE 1
 #define FALSE 0
@@ -48,7 +52,58 @@
  * @brief value for all invalid command
  */
 #define INVALID_COMMAND -1
+/**
+ * @def NANO_IN_SEC 1000000000
+ * @brief nanoseconds in one second
+ */
+#define NANO_IN_SEC 1000000000L
+
+/**
+ * @def struct SudukuShape
+ * @brief the units of a table in one allocation. unitSlots[unitStart[u]..unitStart[u + 1]) are
+ * 		the slots of unit u, slotUnits[slotStart[s]..slotStart[s + 1]) the units of slot s.
+ * 		unitSum is the cage sum of each unit, 0 for none (hasSums is False when all are 0).
+ * 		the shape never changes once built, and boards of many threads share it - so its
+ * 		reference count is atomic. bytes is the size of its allocation.
+ */
+struct SudukuShape
+{
+	atomic_int refCount;
+	size_t bytes;
+	int unitAmount;
+	int hasSums;
+	int* unitStart;
+	int* unitSlots;
+	int* unitSum;
+	int* slotStart;
+	int* slotUnits;
+};
+
+/**
+ * @def struct SudukuBoard
+ * @brief the reference counted storage of a table: the slots, the occupancy bitmask of each unit
+ * 		(maskWords words per unit) and the sum of the values in each unit, all in one allocation.
+ */
+struct SudukuBoard
+{
+	int refCount;
+	SudukuShape* shape;
+	Cell* table;
+	MaskWord* unitMask;
+	int* unitTotal;
+};
 
+/**
+ * @def struct ChoicePoint
+ * @brief a slot filled by solveChoicePoints and the value it holds now. trailMark is the trail
+ * 		size before the slot got its value - the slots deduced from it are above the mark.
+ */
+typedef struct ChoicePoint
+{
+	int slot;
+	int val;
+	int trailMark;
+} ChoicePoint;
 //-------------------------------------------functions----------------------------------------------
 
 
@@ -89,7 +144,7 @@ void firstEmptySlot(Suduku* suduku, SlotIndex* slotIndex)
 	{ 		
 		 for(colIndex = 0; colIndex < suduku->tableSize; colIndex++)
 		 {
-			 if(suduku->table[TABLE(suduku->tableSize, rowIndex, colIndex)] == 0)
+			 if(suduku->board->table[TABLE(suduku->tableSize, rowIndex, colIndex)] == EMPTY_SLOT_VAL)
 			 {
 				 slotIndex->row = rowIndex;
 				 slotIndex->col = colIndex;
@@ -100,35 +155,599 @@ void firstEmptySlot(Suduku* suduku, SlotIndex* slotIndex)
 	return;
 }
 	
+/**
+ * @def buildShape
+ * @brief turn the variant constraints into the units of the table
+ * @param int tableSize - suduku table size
+ * @param SudukuVariant* variant - the constraints, NULL for the classic table
+ * @return the shape, NULL if the constraints are not valid or allocation failed
+ */
+static SudukuShape* buildShape(int tableSize, const SudukuVariant* variant)
+{
+	static const SudukuVariant classic = {NULL, FALSE, 0, NULL, NULL};
+	int slots = tableSize * tableSize, boxSize = findSqrt(tableSize);
+	int slot, row, col, unit, index, amount;
+	
+	variant = variant != NULL ? variant : &classic;
+	if(tableSize <= 0 || tableSize > MAX_TABLE_SIZE || variant->cageAmount < 0 || \
+	   (variant->regions == NULL && boxSize == INVALID_COMMAND) || \
+	   (variant->cageAmount > 0 && (variant->cages == NULL || variant->cageSums == NULL)))
+	{
+		return NULL;
+	}
+	
+	// rows, cols, regions, then the diagonals and the cages
+	int diagonalUnit = 3 * tableSize;
+	int cageUnit = diagonalUnit + (variant->diagonals ? 2 : 0);
+	int unitAmount = cageUnit + variant->cageAmount;
+	int memberships = 3 * slots + (variant->diagonals ? 2 * tableSize : 0) + slots;
+	size_t bytes = sizeof(SudukuShape) + \
+				   (2 * (unitAmount + 1) + slots + 1 + 2 * memberships) * sizeof(int);
+	SudukuShape* shape = (SudukuShape*)malloc(bytes);
+	if(shape == NULL)
+	{
+		//allocation failed
+		printf("allocation failed\n");
+		return NULL;
+	}
+	atomic_init(&shape->refCount, 1);
+	shape->bytes = bytes;
+	shape->unitAmount = unitAmount;
+	shape->hasSums = FALSE;
+	shape->unitStart = (int*)(shape + 1);
+	shape->unitSum = shape->unitStart + unitAmount + 1;
+	shape->slotStart = shape->unitSum + unitAmount + 1;
+	shape->unitSlots = shape->slotStart + slots + 1;
+	shape->slotUnits = shape->unitSlots + memberships;
+	
+	// the units of each slot, counting the slots of each unit on the way
+	memset(shape->unitStart, 0, (unitAmount + 1) * sizeof(int));
+	amount = 0;
+	for(slot = 0; slot < slots; slot++)
+	{
+		row = slot / tableSize;
+		col = slot % tableSize;
+		shape->slotStart[slot] = amount;
+		shape->slotUnits[amount++] = row;
+		shape->slotUnits[amount++] = tableSize + col;
+		if(variant->regions != NULL)
+		{
+			if(variant->regions[slot] < 1 || variant->regions[slot] > tableSize)
+			{
+				free(shape);
+				return NULL;
+			}
+			shape->slotUnits[amount++] = 2 * tableSize + variant->regions[slot] - 1;
+		}
+		else
+		{
+			shape->slotUnits[amount++] = 2 * tableSize + (row / boxSize) * boxSize + col / boxSize;
+		}
+		if(variant->diagonals && row == col)
+		{
+			shape->slotUnits[amount++] = diagonalUnit;
+		}
+		if(variant->diagonals && row + col == tableSize - 1)
+		{
+			shape->slotUnits[amount++] = diagonalUnit + 1;
+		}
+		if(variant->cageAmount > 0 && variant->cages[slot] != 0)
+		{
+			if(variant->cages[slot] < 0 || variant->cages[slot] > variant->cageAmount)
+			{
+				free(shape);
+				return NULL;
+			}
+			shape->slotUnits[amount++] = cageUnit + variant->cages[slot] - 1;
+		}
+		for(index = shape->slotStart[slot]; index < amount; index++)
+		{
+			shape->unitStart[shape->slotUnits[index] + 1]++;
+		}
+	}
+	shape->slotStart[slots] = amount;
+	
+	// each unit must fit its values - regions are full units, cages hold up to tableSize slots
+	// and a sum their values can reach
+	for(unit = 0; unit < unitAmount; unit++)
+	{
+		int size = shape->unitStart[unit + 1];
+		int sum = unit >= cageUnit ? variant->cageSums[unit - cageUnit] : 0;
+		if((unit < cageUnit && size != tableSize) || size == 0 || size > tableSize || \
+		   (sum != 0 && (sum < size * (size + 1) / 2 || \
+						 sum > size * (2 * tableSize - size + 1) / 2)))
+		{
+			free(shape);
+			return NULL;
+		}
+		shape->unitSum[unit] = sum;
+		shape->hasSums |= sum != 0;
+		shape->unitStart[unit + 1] += shape->unitStart[unit];
+	}
+	
+	// the slots of each unit in row by row order - unitStart is the fill position of each unit
+	// on the way, so afterwards it is one unit ahead
+	for(slot = 0; slot < slots; slot++)
+	{
+		for(index = shape->slotStart[slot]; index < shape->slotStart[slot + 1]; index++)
+		{
+			shape->unitSlots[shape->unitStart[shape->slotUnits[index]]++] = slot;
+		}
+	}
+	for(unit = unitAmount; unit > 0; unit--)
+	{
+		shape->unitStart[unit] = shape->unitStart[unit - 1];
+	}
+	shape->unitStart[0] = 0;
+	return shape;
+}
+
+/**
+ * @def releaseShape
+ * @brief drop one reference of the shape and free it when no board uses it
+ */
+static void releaseShape(SudukuShape* shape)
+{
+	if(atomic_fetch_sub(&shape->refCount, 1) == 1)
+	{
+		free(shape);
+	}
+}
+
+/**
+ * @def boardBytes
+ * @brief the size of one board allocation
+ * @param SudukuShape* shape - the units of the table
+ * @param int tableSize - suduku table size
+ * @param int maskWords - number of MaskWords per unit
+ * @return the board size in bytes
+ */
+static size_t boardBytes(const SudukuShape* shape, int tableSize, int maskWords)
+{
+	return sizeof(SudukuBoard) + shape->unitAmount * (maskWords * sizeof(MaskWord) + sizeof(int)) + \
+		   tableSize * tableSize * sizeof(Cell);
+}
+
+/**
+ * @def boardInit
+ * @brief point the board fields into its allocation - masks first so they stay aligned
+ * @param SudukuBoard* board - the board allocation
+ * @param SudukuShape* shape - the units of the table, the board keeps a reference to it
+ * @param int maskWords - number of MaskWords per unit
+ */
+static void boardInit(SudukuBoard* board, SudukuShape* shape, int maskWords)
+{
+	board->refCount = 1;
+	board->shape = shape;
+	atomic_fetch_add(&shape->refCount, 1);
+	board->unitMask = (MaskWord*)(board + 1);
+	board->unitTotal = (int*)(board->unitMask + shape->unitAmount * maskWords);
+	board->table = (Cell*)(board->unitTotal + shape->unitAmount);
+}
+
+/**
+ * @def releaseBoard
+ * @brief drop one reference of the board and free it when no node uses it
+ * @param SudukuBoard* board - the board
+ */
+static void releaseBoard(SudukuBoard* board)
+{
+	if(board != NULL && --board->refCount == 0)
+	{
+		releaseShape(board->shape);
+		free(board);
+	}
+}
+
+/**
+ * @def applySlotValue
+ * @brief put val in the given slot of the board and mark it in the occupancy bitmasks
+ * @param Suduku* suduku - the node that owns the board
+ * @param int tableIndex - the index of the slot in the table
+ * @param int val - the value to put in the slot
+ */
+static void applySlotValue(Suduku* suduku, int tableIndex, int val)
+{
+	SudukuBoard* board = suduku->board;
+	const SudukuShape* shape = board->shape;
+	int word = MASK_WORD(val), index, unit;
+	MaskWord bit = MASK_BIT(val);
+	
+	for(index = shape->slotStart[tableIndex]; index < shape->slotStart[tableIndex + 1]; index++)
+	{
+		unit = shape->slotUnits[index];
+		board->unitMask[unit * suduku->maskWords + word] |= bit;
+	}
+	for(index = shape->slotStart[tableIndex]; shape->hasSums && \
+		index < shape->slotStart[tableIndex + 1]; index++)
+	{
+		board->unitTotal[shape->slotUnits[index]] += val;
+	}
+	board->table[tableIndex] = (Cell)val;
+}
+
+/**
+ * @def clearSlotValue
+ * @brief empty the given slot of the board and unmark its value in the occupancy bitmasks
+ * @param Suduku* suduku - the node that owns the board
+ * @param int tableIndex - the index of the slot in the table
+ * @param int val - the value the slot holds
+ */
+static void clearSlotValue(Suduku* suduku, int tableIndex, int val)
+{
+	SudukuBoard* board = suduku->board;
+	const SudukuShape* shape = board->shape;
+	int word = MASK_WORD(val), index, unit;
+	MaskWord bit = MASK_BIT(val);
+	
+	for(index = shape->slotStart[tableIndex]; index < shape->slotStart[tableIndex + 1]; index++)
+	{
+		unit = shape->slotUnits[index];
+		board->unitMask[unit * suduku->maskWords + word] &= ~bit;
+	}
+	for(index = shape->slotStart[tableIndex]; shape->hasSums && \
+		index < shape->slotStart[tableIndex + 1]; index++)
+	{
+		board->unitTotal[shape->slotUnits[index]] -= val;
+	}
+	board->table[tableIndex] = EMPTY_SLOT_VAL;
+}
+
+/**
+ * @def ownBoard
+ * @brief make the node board private and up to date - copy it if other nodes share it and apply
+ * 		the pending slot of the node.
+ * @param Suduku* suduku - the node
+ * @return False if allocation failed otherwise True
+ */
+static int ownBoard(Suduku* suduku)
+{
+	if(suduku->board->refCount > 1)
+	{
+		size_t bytes = boardBytes(suduku->board->shape, suduku->tableSize, suduku->maskWords);
+		SudukuBoard* board = (SudukuBoard*)malloc(bytes);
+		if(board == NULL)
+		{
+			//allocation failed
+			printf("allocation failed\n");
+			return FALSE;
+		}
+		memcpy(board, suduku->board, bytes);
+		boardInit(board, suduku->board->shape, suduku->maskWords);
+		releaseBoard(suduku->board);
+		suduku->board = board;
+	}
+	
+	if(suduku->pendingSlot != NO_PENDING_SLOT)
+	{
+		applySlotValue(suduku, suduku->pendingSlot, suduku->pendingVal);
+		suduku->pendingSlot = NO_PENDING_SLOT;
+	}
+	return TRUE;
+}
+
+/**
+ * @def cageCandidates
+ * @brief drop the values that leave the cage sum out of reach - the other empty slots of the
+ * 		cage take distinct free values, so what is left of the sum must lie between the smallest
+ * 		and the largest sum they can make
+ * @param Suduku* suduku - the node, its board must be up to date
+ * @param int unit - the cage unit
+ * @param MaskWord* candidates - maskWords words, the values that stay are kept
+ */
+static void cageCandidates(const Suduku* suduku, int unit, MaskWord* candidates)
+{
+	const SudukuBoard* board = suduku->board;
+	const SudukuShape* shape = board->shape;
+	const MaskWord* used = board->unitMask + unit * suduku->maskWords;
+	Cell freeVals[MAX_TABLE_SIZE];
+	int word, val, index, freeAmount = 0, filled = 0;
+	
+	for(word = 0; word < suduku->maskWords; word++)
+	{
+		filled += __builtin_popcountll(used[word]);
+	}
+	for(val = 1; val <= suduku->tableSize; val++)
+	{
+		if(!(used[MASK_WORD(val)] & MASK_BIT(val)))
+		{
+			freeVals[freeAmount++] = (Cell)val;
+		}
+	}
+	
+	// the other empty slots and the sum they have to make together with val
+	int others = shape->unitStart[unit + 1] - shape->unitStart[unit] - filled - 1;
+	int left = shape->unitSum[unit] - board->unitTotal[unit];
+	int smallest = 0, smallestMore = 0, largest = 0, largestMore = 0;
+	for(index = 0; index < others + 1 && index < freeAmount; index++)
+	{
+		smallestMore += freeVals[index];
+		largestMore += freeVals[freeAmount - 1 - index];
+		if(index < others)
+		{
+			smallest = smallestMore;
+			largest = largestMore;
+		}
+	}
+	
+	for(index = 0; index < freeAmount; index++)
+	{
+		val = freeVals[index];
+		// when val is one of the values the bound takes, the next value replaces it
+		int low = index < others ? smallestMore - val : smallest;
+		int high = index >= freeAmount - others ? largestMore - val : largest;
+		if(others >= freeAmount || left - val < low || left - val > high)
+		{
+			candidates[MASK_WORD(val)] &= ~MASK_BIT(val);
+		}
+	}
+}
+
+/**
+ * @def slotCandidates
+ * @brief the values that are still free for the given slot, as a multi-word bitmask
+ * @param Suduku* suduku - the node, its board must be up to date
+ * @param int tableIndex - the index of the slot in the table
+ * @param MaskWord* candidates - maskWords words that will hold the free values
+ * @return the number of free values
+ */
+static int slotCandidates(const Suduku* suduku, int tableIndex, MaskWord* candidates)
+{
+	const SudukuBoard* board = suduku->board;
+	const SudukuShape* shape = board->shape;
+	const int* units = shape->slotUnits + shape->slotStart[tableIndex];
+	int unitAmount = shape->slotStart[tableIndex + 1] - shape->slotStart[tableIndex];
+	int word, index, amount = 0;
+	MaskWord used;
+	
+	for(word = 0; word < suduku->maskWords; word++)
+	{
+		used = 0;
+		for(index = 0; index < unitAmount; index++)
+		{
+			used |= board->unitMask[units[index] * suduku->maskWords + word];
+		}
+		candidates[word] = ~used;
+	}
+	// clear the bits above tableSize in the last word
+	if(suduku->tableSize % MASK_WORD_BITS != 0)
+	{
+		candidates[suduku->maskWords - 1] &= MASK_BIT(suduku->tableSize + 1) - 1;
+	}
+	for(index = 0; shape->hasSums && index < unitAmount; index++)
+	{
+		if(shape->unitSum[units[index]] != 0)
+		{
+			cageCandidates(suduku, units[index], candidates);
+		}
+	}
+	for(word = 0; word < suduku->maskWords; word++)
+	{
+		amount += __builtin_popcountll(candidates[word]);
+	}
+	return amount;
+}
+
+/**
+ * @def orderRank
+ * @brief the place of val in the seeded value order of the slot (slot rank for val 0) - a hash, so
+ * 		each seed gives another order and the same seed always gives the same one
+ */
+static unsigned int orderRank(unsigned int seed, int slot, int val)
+{
+	unsigned int rank = seed * 0x9E3779B9u ^ (unsigned int)slot * 0x85EBCA6Bu ^ \
+						(unsigned int)val * 0xC2B2AE35u;
+	rank ^= rank >> 16;
+	rank *= 0x7FEB352Du;
+	rank ^= rank >> 15;
+	rank *= 0x846CA68Bu;
+	rank ^= rank >> 16;
+	return rank;
+}
+
+/**
+ * @def orderedBefore
+ * @brief check if value first comes before value second in the seeded order of the slot
+ */
+static int orderedBefore(unsigned int seed, int slot, int first, int second)
+{
+	unsigned int firstRank = orderRank(seed, slot, first);
+	unsigned int secondRank = orderRank(seed, slot, second);
+	return firstRank < secondRank || (firstRank == secondRank && first < second);
+}
+
+/**
+ * @def seededOrder
+ * @brief check if the node branches in a seeded order
+ */
+static int seededOrder(const Suduku* suduku)
+{
+	return suduku->context != NULL && suduku->context->seed != 0;
+}
+
+/**
+ * @def expandAllowed
+ * @brief count one expanded node and check the node budget and the stop flag
+ * @return False if the search has to stop (the context is marked aborted)
+ */
+static int expandAllowed(SudukuContext* context)
+{
+	if(context == NULL)
+	{
+		return TRUE;
+	}
+	context->nodes++;
+	if((context->nodeBudget != 0 && context->nodes > context->nodeBudget) || \
+	   (context->stop != NULL && atomic_load_explicit(context->stop, memory_order_relaxed)))
+	{
+		context->aborted = TRUE;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * @def contextDeduce
+ * @brief run the deductions of the context level on the node (see deduce), and add their time to
+ * 		the context when it asks for it
+ */
+static int contextDeduce(Suduku* suduku, SudukuContext* context, int* placed, int* placedAmount)
+{
+	if(!context->timeLogic)
+	{
+		return deduce(suduku, context->logicLevel, context->logicHits, context->logicScratch, placed,
+					  placedAmount);
+	}
+	
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int valid = deduce(suduku, context->logicLevel, context->logicHits, context->logicScratch,
+					   placed, placedAmount);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	context->logicNanos += (end.tv_sec - start.tv_sec) * NANO_IN_SEC + end.tv_nsec - start.tv_nsec;
+	return valid;
+}
+
+/**
+ * @def fewestCandidatesSlot
+ * @brief the empty slot with the fewest free values, ties broken by the seeded slot order
+ * @param Suduku* suduku - the node, its board must be up to date
+ * @return the slot index, NO_PENDING_SLOT if the table is full
+ */
+static int fewestCandidatesSlot(const Suduku* suduku)
+{
+	MaskWord candidates[MAX_MASK_WORDS];
+	unsigned int seed = suduku->context->seed;
+	int slot, amount, best = NO_PENDING_SLOT, bestAmount = suduku->tableSize + 1;
+	
+	// a slot with one value (or none) can not be beaten
+	for(slot = 0; slot < suduku->tableSize * suduku->tableSize && bestAmount > 1; slot++)
+	{
+		if(suduku->board->table[slot] != EMPTY_SLOT_VAL)
+		{
+			continue;
+		}
+		amount = slotCandidates(suduku, slot, candidates);
+		if(amount < bestAmount || (amount == bestAmount && \
+		   orderRank(seed, slot, EMPTY_SLOT_VAL) < orderRank(seed, best, EMPTY_SLOT_VAL)))
+		{
+			best = slot;
+			bestAmount = amount;
+		}
+	}
+	return best;
+}
+
+/**
+ * @overload sudukutree.h
+ */
+int getSlotCandidates(const Suduku* suduku, int tableIndex, MaskWord* candidates)
+{
+	return slotCandidates(suduku, tableIndex, candidates);
+}
+
+/**
+ * @overload sudukutree.h
+ */
+int getUnitAmount(const Suduku* suduku)
+{
+	return suduku->board->shape->unitAmount;
+}
+
+/**
+ * @overload sudukutree.h
+ */
+int getUnitSlots(const Suduku* suduku, int unit, const int** slots)
+{
+	const SudukuShape* shape = suduku->board->shape;
+	*slots = shape->unitSlots + shape->unitStart[unit];
+	return shape->unitStart[unit + 1] - shape->unitStart[unit];
+}
+
+/**
+ * @overload sudukutree.h
+ */
+int getUnitSum(const Suduku* suduku, int unit)
+{
+	return suduku->board->shape->unitSum[unit];
+}
+
+/**
+ * @overload sudukutree.h
+ */
+int getSlotUnits(const Suduku* suduku, int tableIndex, const int** units)
+{
+	const SudukuShape* shape = suduku->board->shape;
+	*units = shape->slotUnits + shape->slotStart[tableIndex];
+	return shape->slotStart[tableIndex + 1] - shape->slotStart[tableIndex];
+}
+
 /**
  * @overload sudukutree.h
  */	
 void* createSudukuTable(const int tableSize)
 {
-	Suduku* suduku = (Suduku*)malloc(sizeof(Suduku));
+	return createVariantTable(tableSize, NULL);
+}
+
+/**
+ * @overload sudukutree.h
+ */
+void* createVariantTable(const int tableSize, const SudukuVariant* variant)
+{
+	SudukuShape* shape = buildShape(tableSize, variant);
+	if(shape == NULL)
+	{
+		return NULL;
+	}
 	
+	Suduku* suduku = (Suduku*)malloc(sizeof(Suduku));
 	if(suduku == NULL)
 	{
 		//allocation failed
 		printf("allocation failed\n");
+		releaseShape(shape);
 		return NULL;
 	}
 	
 	suduku-> tableSize = tableSize;
-	suduku-> table = (int*)malloc(tableSize * tableSize * sizeof(int));
-	if(suduku-> table == NULL)
+	// regions take the place of the sub squres, so a variant table needs no sqrt
+	suduku-> boxSize = variant != NULL && variant->regions != NULL ? 0 : findSqrt(tableSize);
+	suduku-> maskWords = MASK_WORDS(tableSize);
+	// empty slots and empty masks are all zero
+	suduku-> board = (SudukuBoard*)calloc(1, boardBytes(shape, tableSize, suduku->maskWords));
+	if(suduku-> board == NULL)
 	{
 		//allocation failed
 		printf("allocation failed\n");
+		releaseShape(shape);
 		free(suduku);
 		return NULL;
 	}
+	// the board takes its own reference
+	boardInit(suduku->board, shape, suduku->maskWords);
+	releaseShape(shape);
 	
 	suduku-> fullSlots = 0;
+	suduku-> context = NULL;
+	suduku-> pendingSlot = NO_PENDING_SLOT;
+	suduku-> pendingVal = EMPTY_SLOT_VAL;
 	
 	return suduku;
 }
 
+/**
+ * @overload sudukutree.h
+ */	
+void clearNode(void* suduku)
+{
+	if(suduku != NULL)
+	{
+		releaseBoard(((Suduku*)suduku)->board);
+		((Suduku*)suduku)->board = NULL;
+	}
+}
+
 /**
  * @overload sudukutree.h
  */	
@@ -136,14 +755,8 @@ void freeNode(void* suduku)
 {
 	if(suduku != NULL)
 	{
-		Suduku* temp_table = (Suduku*)suduku;
-		if(temp_table != NULL)
-		{
-			free(temp_table->table);
-			temp_table->table = NULL;
-			free(suduku);
-			suduku = NULL;
-		}
+		clearNode(suduku);
+		free(suduku);
 	}
 }
 
@@ -159,88 +772,214 @@ unsigned int getNodeVal(void* suduku)
 /**
  * @overload sudukutree.h
  */
-void* copyNode(void* suduku)
+unsigned long getNodeRank(void* suduku)
 {
-	Suduku* sudukuTempTable = (Suduku*)suduku;
+	Suduku* sudukuTable = (Suduku*)suduku;
+	const SudukuShape* shape = sudukuTable->board->shape;
+	MaskWord candidates[MAX_MASK_WORDS];
+	int slot = sudukuTable->pendingSlot, val = sudukuTable->pendingVal;
+	int unitIndex, index, peer, amount;
+	unsigned long left = 0;
 	
-	Suduku* sudukuNewTable = (Suduku*)createSudukuTable(sudukuTempTable->tableSize);
-	if(sudukuNewTable == NULL)
+	if(slot == NO_PENDING_SLOT)
 	{
-		//allocation faild
+		return sudukuTable->fullSlots * RANK_FULL_SLOT;
+	}
+	// only the slots that share a unit with the pending value lose candidates to it
+	for(unitIndex = shape->slotStart[slot]; unitIndex < shape->slotStart[slot + 1]; unitIndex++)
+	{
+		int unit = shape->slotUnits[unitIndex];
+		for(index = shape->unitStart[unit]; index < shape->unitStart[unit + 1]; index++)
+		{
+			peer = shape->unitSlots[index];
+			if(peer == slot || sudukuTable->board->table[peer] != EMPTY_SLOT_VAL)
+			{
+				continue;
+			}
+			amount = slotCandidates(sudukuTable, peer, candidates);
+			if(candidates[MASK_WORD(val)] & MASK_BIT(val))
+			{
+				amount--;
+			}
+			// a slot with no value left - the node has no solution
+			if(amount == 0)
+			{
+				return 0;
+			}
+			left += amount;
+		}
+	}
+	return sudukuTable->fullSlots * RANK_FULL_SLOT + left;
+}
+
+/**
+ * @overload sudukutree.h
+ */
+Suduku* cloneNode(const Suduku* suduku)
+{
+	size_t bytes = boardBytes(suduku->board->shape, suduku->tableSize, suduku->maskWords);
+	Suduku* clone = (Suduku*)malloc(sizeof(Suduku));
+	SudukuBoard* board = (SudukuBoard*)malloc(bytes);
+	if(clone == NULL || board == NULL)
+	{
+		//allocation failed
+		printf("allocation failed\n");
+		free(clone);
+		free(board);
 		return NULL;
 	}
 	
-	sudukuNewTable->fullSlots = sudukuTempTable-> fullSlots;
-	
-	int tableIndex;
-	
-	for(tableIndex = 0 ; tableIndex < (sudukuNewTable->tableSize)*(sudukuNewTable->tableSize);\
-		tableIndex++)
+	// only the shape is shared - its reference count is safe between threads
+	memcpy(board, suduku->board, bytes);
+	boardInit(board, suduku->board->shape, suduku->maskWords);
+	*clone = *suduku;
+	clone->board = board;
+	clone->context = NULL;
+	ownBoard(clone);
+	return clone;
+}
+
+/**
+ * @overload sudukutree.h
+ */
+void* copyNode(void* suduku)
+{
+	Suduku* sudukuNewTable = (Suduku*)malloc(sizeof(Suduku));
+	if(sudukuNewTable == NULL)
 	{
-		(sudukuNewTable->table)[tableIndex] = (sudukuTempTable->table)[tableIndex];
+		//allocation faild
+		return NULL;
 	}
 	
+	// the copy shares the board - it is copied only when one of them is changed
+	*sudukuNewTable = *(Suduku*)suduku;
+	sudukuNewTable->board->refCount++;
+	
 	return sudukuNewTable;
 }
 
 /**
  * @overload sudukutree.h
  */
-void checkRow(Suduku* suduku, SlotIndex* index, int* possibleValues)
+int getSlotValue(const Suduku* suduku, int tableIndex)
 {
-	int i;
-	int slotVal;
-	for(i = 0; i<suduku->tableSize; i++)
+	if(tableIndex == suduku->pendingSlot)
 	{
-		slotVal = suduku->table[TABLE(suduku->tableSize, index->row, i)];
-		if(slotVal != EMPTY_SLOT_VAL)
-		{
-			possibleValues[slotVal - 1]++;
-		}
+		return suduku->pendingVal;
 	}
+	return suduku->board->table[tableIndex];
 }
 
 /**
  * @overload sudukutree.h
  */
-void checkCol(Suduku* suduku, SlotIndex* index, int* possibleValues)
+int setSlotValue(Suduku* suduku, int tableIndex, int val)
 {
-	int i;
-	int slotVal;
+	if(!ownBoard(suduku))
+	{
+		return FALSE;
+	}
 	
-	for(i = 0; i<suduku->tableSize; i++)
+	MaskWord candidates[MAX_MASK_WORDS];
+	slotCandidates(suduku, tableIndex, candidates);
+	if(val < 1 || val > suduku->tableSize || !(candidates[MASK_WORD(val)] & MASK_BIT(val)))
 	{
-		slotVal = suduku->table[TABLE(suduku->tableSize, i, index->col)];
-		if(slotVal != EMPTY_SLOT_VAL)
-		{
-			possibleValues[slotVal - 1]++;
-		}
+		return FALSE;
 	}
+	
+	applySlotValue(suduku, tableIndex, val);
+	suduku->fullSlots++;
+	
+	return TRUE;
 }
 
 /**
- * @overload sudukutree.h
+ * @def expandNode
+ * @brief write all valid children of the node into the given array, each child shares the node
+ * 		board (its reference is counted) and keeps only the value it puts in the slot
+ * @param Suduku* tempSuduku - the suduku node
+ * @param Suduku* children - room for tableSize children
+ * @return the number of node children
  */
-void checksubSqure(Suduku* suduku, SlotIndex* index, int* possibleValues)
+static int expandNode(Suduku* tempSuduku, Suduku* children)
 {
-	// we want to find the root of the sub string to check for PossibleValues
-	int sqrt = findSqrt(suduku->tableSize); 
+	SudukuContext* context = tempSuduku->context;
+	//an aborted search expands nothing, so it drains its stack and stops
+	if(!expandAllowed(context) || !ownBoard(tempSuduku))
+	{
+		return 0;
+	}
+	
+	//fill the forced slots first - a table with no solution has no children
+	int deduced = context != NULL && context->logicLevel > LOGIC_NONE;
+	if(deduced && !contextDeduce(tempSuduku, context, NULL, NULL))
+	{
+		return 0;
+	}
 	
-	int subSqureRow = (int)(index->row / sqrt)*(sqrt);
-	int subSqureCol = (int)(index->col / sqrt)*(sqrt);
+	SlotIndex emptySlotIndex = {DEFAULT_ROW_INDEX, DEFAULT_COL_INDEX};
+	if(seededOrder(tempSuduku))
+	{
+		int emptySlot = fewestCandidatesSlot(tempSuduku);
+		if(emptySlot != NO_PENDING_SLOT)
+		{
+			emptySlotIndex.row = emptySlot / tempSuduku->tableSize;
+			emptySlotIndex.col = emptySlot % tempSuduku->tableSize;
+		}
+	}
+	else
+	{
+		firstEmptySlot(tempSuduku, &emptySlotIndex);
+	}
 	
-	int col, row, slotVal;
-	for(row = subSqureRow; row < subSqureRow + sqrt; row++)
+	//reach to the end of the table
+	if(emptySlotIndex.col == DEFAULT_COL_INDEX || emptySlotIndex.row == DEFAULT_ROW_INDEX)
 	{
-		for(col = subSqureCol; col < subSqureCol + sqrt; col++)
+		if(!deduced)
 		{
-			slotVal = suduku->table[TABLE(suduku->tableSize, row, col)];
-			if(slotVal != EMPTY_SLOT_VAL)
-			{
-				possibleValues[slotVal - 1]++;
-			}
+			return 0;
 		}
+		//the deductions solved the table - its only child is the full table, so it is visited
+		children[0] = *tempSuduku;
+		tempSuduku->board->refCount++;
+		return 1;
 	}
+	
+	//check how mach possible Values the are - the occupancy masks already hold the used values
+	MaskWord candidates[MAX_MASK_WORDS];
+	int slot = TABLE(tempSuduku->tableSize, emptySlotIndex.row, emptySlotIndex.col);
+	int word, made = 0;
+	MaskWord bits;
+	
+	slotCandidates(tempSuduku, slot, candidates);
+	for(word = 0; word < tempSuduku->maskWords; word++)
+	{
+		for(bits = candidates[word]; bits != 0; bits &= bits - 1)
+		{
+			children[made] = *tempSuduku;
+			children[made].pendingSlot = slot;
+			children[made].pendingVal = (Cell)(word * MASK_WORD_BITS + __builtin_ctzll(bits) + 1);
+			children[made].fullSlots++;
+			made++;
+		}
+	}
+	tempSuduku->board->refCount += made;
+	
+	//the first child is searched first - put the children in the seeded value order
+	Suduku child;
+	int sorted, index;
+	for(sorted = 1; seededOrder(tempSuduku) && sorted < made; sorted++)
+	{
+		child = children[sorted];
+		for(index = sorted; index > 0 && orderedBefore(context->seed, slot, child.pendingVal, \
+													   children[index - 1].pendingVal); index--)
+		{
+			children[index] = children[index - 1];
+		}
+		children[index] = child;
+	}
+	
+	return made;
 }
 
 /**
@@ -248,77 +987,254 @@ void checksubSqure(Suduku* suduku, SlotIndex* index, int* possibleValues)
  */
 int getNodeChildren(void* suduku, void*** optionalSolutions)
 {
-	
-	Suduku* tempSuduku = (Suduku*)suduku;
-	SlotIndex emptySlotIndex = {DEFAULT_ROW_INDEX, DEFAULT_COL_INDEX};
-	firstEmptySlot(tempSuduku, &emptySlotIndex);
-	
-	//reach to the end of the table
-	if(emptySlotIndex.col == DEFAULT_COL_INDEX || emptySlotIndex.row == DEFAULT_ROW_INDEX)
+	Suduku children[MAX_TABLE_SIZE];
+	int childrenCounter = expandNode((Suduku*)suduku, children), made, index;
+	if(childrenCounter == 0)
 	{
 		return 0;
 	}
 	
-	int* possibleValues = (int*)malloc(tempSuduku->tableSize * sizeof(int));
-	if(possibleValues == NULL)
+	//create an array of children - each children is the suduku table with different possible value
+	Suduku** childrenArray = (Suduku**)malloc(childrenCounter * sizeof(Suduku*));
+	for(made = 0; childrenArray != NULL && made < childrenCounter; made++)
 	{
-		//allocation faild
+		childrenArray[made] = (Suduku*)malloc(sizeof(Suduku));
+		if(childrenArray[made] == NULL)
+		{
+			break;
+		}
+		*childrenArray[made] = children[made];
+	}
+	
+	if(childrenArray == NULL || made < childrenCounter)
+	{
+		//allocation faild - no child is handed out, all of them release their board
+		for(index = 0; index < childrenCounter; index++)
+		{
+			clearNode(&children[index]);
+		}
+		for(index = 0; childrenArray != NULL && index < made; index++)
+		{
+			free(childrenArray[index]);
+		}
+		free(childrenArray);
+		*optionalSolutions = NULL;
 		return 0;
 	}
-	int index;
-	//initalize possibleValues array 
-	for(index = 0; index < tempSuduku->tableSize; index++)
+	*optionalSolutions = (void**)childrenArray;
+	return childrenCounter;
+}
+
+/**
+ * @overload sudukutree.h
+ */
+int getNodeChildrenInto(void* suduku, void* children, int capacity)
+{
+	if(capacity < ((Suduku*)suduku)->tableSize)
 	{
-		*(possibleValues + index) = POSSIBLE_VALUE_INITIALIZE;
+		return 0;
 	}
-	//check for valid possible Values 
-	checkCol(suduku, &emptySlotIndex, possibleValues);
-	checkRow(suduku, &emptySlotIndex, possibleValues);
-	checksubSqure(suduku, &emptySlotIndex, possibleValues);
+	return expandNode((Suduku*)suduku, (Suduku*)children);
+}
+
+/**
+ * @def nextCandidate
+ * @brief the smallest value above val that is still free for the given slot (the next one in the
+ * 		seeded value order, when the node has one)
+ * @param Suduku* suduku - the node, its board must be up to date
+ * @param int slot - the index of the slot in the table
+ * @param int val - the last value tried, 0 for none
+ * @return the next value, EMPTY_SLOT_VAL if there is none
+ */
+static int nextCandidate(const Suduku* suduku, int slot, int val)
+{
+	MaskWord candidates[MAX_MASK_WORDS];
+	int word, next = EMPTY_SLOT_VAL, candidate;
+	MaskWord bits;
 	
-	//check how mach possible Values the are
-	int childrenCounter = 0;
-	for(index = 0; index < tempSuduku->tableSize; index++)
+	slotCandidates(suduku, slot, candidates);
+	if(seededOrder(suduku))
 	{
-		if(*(possibleValues + index) == POSSIBLE_VALUE_INITIALIZE)
+		unsigned int seed = suduku->context->seed;
+		for(word = 0; word < suduku->maskWords; word++)
 		{
-			childrenCounter++;	
+			for(bits = candidates[word]; bits != 0; bits &= bits - 1)
+			{
+				candidate = word * MASK_WORD_BITS + __builtin_ctzll(bits) + 1;
+				if((val == EMPTY_SLOT_VAL || orderedBefore(seed, slot, val, candidate)) && \
+				   (next == EMPTY_SLOT_VAL || orderedBefore(seed, slot, candidate, next)))
+				{
+					next = candidate;
+				}
+			}
 		}
+		return next;
 	}
-	
-	//create an array of children - each children is the suduku table with different possible value
-	Suduku** childrenArray;
-	
-	childrenArray = (Suduku**)malloc(childrenCounter * sizeof(Suduku*));
-	//need to check for faild allocation
-	if(childrenArray == NULL)
+	for(word = 0; word < suduku->maskWords; word++)
 	{
-		//allocation faild
-		return 0;
+		// drop the values up to val
+		if((word + 1) * MASK_WORD_BITS <= val)
+		{
+			continue;
+		}
+		if(word * MASK_WORD_BITS < val)
+		{
+			candidates[word] &= ~(MASK_BIT(val + 1) - 1);
+		}
+		if(candidates[word] != 0)
+		{
+			return word * MASK_WORD_BITS + __builtin_ctzll(candidates[word]) + 1;
+		}
+	}
+	return EMPTY_SLOT_VAL;
+}
+
+/**
+ * @def nextEmptySlot
+ * @brief finds the first empty slot from the given slot on
+ * @return the slot index, NO_PENDING_SLOT if the table is full
+ */
+static int nextEmptySlot(const Suduku* suduku, int from)
+{
+	int slot;
+	for(slot = from; slot < suduku->tableSize * suduku->tableSize; slot++)
+	{
+		if(suduku->board->table[slot] == EMPTY_SLOT_VAL)
+		{
+			return slot;
+		}
+	}
+	return NO_PENDING_SLOT;
+}
+
+/**
+ * @def choiceSlot
+ * @brief the slot of the next choice point - the first empty slot from the given slot on, or the
+ * 		slot with the fewest values when the node has a seeded order
+ * @return the slot index, NO_PENDING_SLOT if the table is full
+ */
+static int choiceSlot(const Suduku* suduku, int from)
+{
+	return seededOrder(suduku) ? fewestCandidatesSlot(suduku) : nextEmptySlot(suduku, from);
+}
+
+/**
+ * @def undoTrail
+ * @brief empty the slots the deductions filled, down to the given trail size
+ */
+static void undoTrail(Suduku* suduku, const int* trail, int* trailSize, int mark)
+{
+	while(*trailSize > mark)
+	{
+		int slot = trail[--(*trailSize)];
+		clearSlotValue(suduku, slot, suduku->board->table[slot]);
+		suduku->fullSlots--;
+	}
+}
+
+/**
+ * @overload sudukutree.h
+ */
+int solveChoicePoints(Suduku* suduku, size_t* peakMemory)
+{
+	if(!ownBoard(suduku))
+	{
+		return FALSE;
 	}
 	
-	*optionalSolutions = (void**)childrenArray;
+	SudukuContext* context = suduku->context;
+	int level = context != NULL ? context->logicLevel : LOGIC_NONE;
+	int empties = suduku->tableSize * suduku->tableSize - suduku->fullSlots;
+	// the choice points grow with the search depth. the trail of the slots filled by the
+	// deductions may hold all the empty slots, it is only needed when there are deductions
+	int capacity = suduku->tableSize, trailCapacity = level > LOGIC_NONE ? empties + 1 : 0;
+	ChoicePoint* choices = (ChoicePoint*)malloc(capacity * sizeof(ChoicePoint));
+	int* trail = trailCapacity > 0 ? (int*)malloc(trailCapacity * sizeof(int)) : NULL;
+	if(choices == NULL || (trailCapacity > 0 && trail == NULL))
+	{
+		//allocation failed
+		printf("allocation failed\n");
+		free(choices);
+		free(trail);
+		return FALSE;
+	}
 	
-	Suduku* child = NULL;
+	int depth = 0, trailSize = 0, placed, valid, val;
+	// the slots forced by the given table stay filled
+	int rootValid = level == LOGIC_NONE || \
+					contextDeduce(suduku, context, trail, &trailSize);
+	int slot = rootValid ? choiceSlot(suduku, 0) : NO_PENDING_SLOT;
 	
-	for(index = 0; index < tempSuduku->tableSize; index++)
+	while(slot != NO_PENDING_SLOT)
 	{
-		//if current value is optional
-		if(*(possibleValues + index) == POSSIBLE_VALUE_INITIALIZE)
+		if(depth == capacity)
+		{
+			ChoicePoint* grown = (ChoicePoint*)realloc(choices, 2 * capacity * sizeof(ChoicePoint));
+			if(grown == NULL)
+			{
+				//allocation failed - leave the search like there is no solution
+				printf("allocation failed\n");
+				break;
+			}
+			choices = grown;
+			capacity *= 2;
+		}
+		// new choice point on the next empty slot, then try its values in order
+		choices[depth].slot = slot;
+		choices[depth].val = EMPTY_SLOT_VAL;
+		choices[depth].trailMark = trailSize;
+		depth++;
+		
+		// backtrack until some choice point has another value to try
+		while(depth > 0)
 		{
-			child = (Suduku*)copyNode(tempSuduku);
-			child->table[TABLE(tempSuduku->tableSize, emptySlotIndex.row, emptySlotIndex.col)] = \
-			index + 1;
-			child->fullSlots++;
-			*childrenArray = child;
-			childrenArray++;
-			
-		}	
+			ChoicePoint* choice = &choices[depth - 1];
+			undoTrail(suduku, trail, &trailSize, choice->trailMark);
+			if(choice->val != EMPTY_SLOT_VAL)
+			{
+				clearSlotValue(suduku, choice->slot, choice->val);
+				suduku->fullSlots--;
+			}
+			val = nextCandidate(suduku, choice->slot, choice->val);
+			if(val != EMPTY_SLOT_VAL && !expandAllowed(context))
+			{
+				// out of budget or stopped - leave the search like there is no solution
+				depth = 0;
+				break;
+			}
+			if(val != EMPTY_SLOT_VAL)
+			{
+				applySlotValue(suduku, choice->slot, val);
+				suduku->fullSlots++;
+				choice->val = val;
+				// a value the deductions refute is undone like a dead end
+				placed = 0;
+				valid = level == LOGIC_NONE || \
+						contextDeduce(suduku, context, trail + trailSize, &placed);
+				trailSize += placed;
+				if(valid)
+				{
+					break;
+				}
+				continue;
+			}
+			depth--;
+		}
+		if(depth == 0)
+		{
+			break;
+		}
+		slot = choiceSlot(suduku, choices[depth - 1].slot + 1);
 	}
 	
-	free(possibleValues);
-	possibleValues = NULL;
-	
-	return childrenCounter;	
+	if(peakMemory != NULL)
+	{
+		*peakMemory = sizeof(Suduku) + suduku->board->shape->bytes + \
+					  boardBytes(suduku->board->shape, suduku->tableSize, suduku->maskWords) + \
+					  capacity * sizeof(ChoicePoint) + trailCapacity * sizeof(int) + \
+					  (level > LOGIC_NONE ? deduceBytes(suduku) : 0);
+	}
+	free(choices);
+	free(trail);
+	return rootValid && slot == NO_PENDING_SLOT;
 }
-
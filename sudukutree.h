@@ -7,16 +7,166 @@
 #ifndef SUDUKOTREE_H
 #define SUDUKOTREE_H
 
+#include <stddef.h>
+#include <stdatomic.h>
+
+/**
+ * @def MAX_SQRT_VAL 15
+ * @brief max possible sqrt value - the largest table is MAX_SQRT_VAL^2 x MAX_SQRT_VAL^2
+ */
+#ifndef MAX_SQRT_VAL
+#define MAX_SQRT_VAL 15
+#endif
+/**
+ * @def MAX_TABLE_SIZE
+ * @brief max possible table size
+ */
+#define MAX_TABLE_SIZE (MAX_SQRT_VAL * MAX_SQRT_VAL)
+
+/**
+ * @def Cell
+ * @brief the type of one slot in the table - the narrowest type that holds MAX_TABLE_SIZE, so
+ * 		tables up to 225x225 use one byte per slot and larger builds switch to two bytes.
+ */
+#if MAX_TABLE_SIZE <= 255
+typedef unsigned char Cell;
+#else
+typedef unsigned short Cell;
+#endif
+
+/**
+ * @def MaskWord
+ * @brief one word of an occupancy bitmask - bit (val - 1) is set when val is used in the unit
+ */
+typedef unsigned long long MaskWord;
+
+/**
+ * @def MASK_WORD_BITS 64
+ * @brief number of values each MaskWord holds
+ */
+#define MASK_WORD_BITS 64
+/**
+ * @def MASK_WORDS(N) 
+ * @brief number of MaskWords needed for the bitmask of one unit in table of size N
+ */
+#define MASK_WORDS(N) (((N) + MASK_WORD_BITS - 1) / MASK_WORD_BITS)
+/**
+ * @def MASK_BIT(val)
+ * @brief the bit of val inside its MaskWord
+ */
+#define MASK_BIT(val) (1ULL << (((val) - 1) % MASK_WORD_BITS))
+/**
+ * @def MASK_WORD(val)
+ * @brief the index of the MaskWord that holds val
+ */
+#define MASK_WORD(val) (((val) - 1) / MASK_WORD_BITS)
+/**
+ * @def MAX_MASK_WORDS
+ * @brief number of MaskWords in the bitmask of one unit in the largest table
+ */
+#define MAX_MASK_WORDS MASK_WORDS(MAX_TABLE_SIZE)
+
+/**
+ * @def MAX_SLOT_UNITS 6
+ * @brief max units of one slot - row, col, sub squre (or region), two diagonals and a cage
+ */
+#define MAX_SLOT_UNITS 6
+
+/**
+ * @def struct SudukuVariant
+ * @brief the constraints of a variant table, besides its rows and cols (all may be left 0/NULL
+ * 		for the classic table). slots are numbered row by row.
+ * 		regions - tableSize * tableSize region numbers (1..tableSize) that replace the sub
+ * 			squres (jigsaw), each region has tableSize slots. NULL for the sub squres.
+ * 		diagonals - True if both main diagonals hold each value once (X-suduku).
+ * 		cageAmount, cages - cage number (1..cageAmount, 0 for none) of each slot. the values of a
+ * 			cage do not repeat, and add up to cageSums[cage - 1] unless it is 0 (killer).
+ */
+typedef struct SudukuVariant
+{
+	const int* regions;
+	int diagonals;
+	int cageAmount;
+	const int* cages;
+	const int* cageSums;
+} SudukuVariant;
+
+/**
+ * @def enum LogicTechnique
+ * @brief the deductions of sudukulogic, each counted on its own in SudukuContext
+ */
+typedef enum LogicTechnique
+{
+	LOGIC_NAKED_SINGLE,
+	LOGIC_HIDDEN_SINGLE,
+	LOGIC_LOCKED_CANDIDATES,
+	LOGIC_NAKED_PAIR,
+	LOGIC_NAKED_TRIPLE,
+	LOGIC_HIDDEN_PAIR,
+	LOGIC_HIDDEN_TRIPLE,
+	LOGIC_X_WING,
+	LOGIC_SWORDFISH,
+	LOGIC_TECHNIQUES
+} LogicTechnique;
+
+/**
+ * @def struct SudukuContext
+ * @brief the settings and counters of one solve, shared by all its nodes - logicLevel is the
+ * 		deduction strength used between search steps (see sudukulogic.h), logicHits counts how 
+ * 		many times each technique made progress.
+ * 		seed picks the branch order: 0 is the first empty slot and its values from the smallest,
+ * 		any other seed is the slot with the fewest values (ties and values in a seeded order).
+ * 		nodes counts the expanded nodes - the search is aborted when it passes nodeBudget
+ * 		(0 for no budget) or when stop is set (NULL for never), aborted tells it was.
+ * 		timeLogic asks to add the time of the deductions to logicNanos.
+ * 		logicScratch is the deduce scratch (deduceBytes) the search reuses in every node, NULL
+ * 		for deduce to allocate its own.
+ */
+typedef struct SudukuContext
+{
+	int logicLevel;
+	unsigned long logicHits[LOGIC_TECHNIQUES];
+	unsigned int seed;
+	unsigned long nodes;
+	unsigned long nodeBudget;
+	atomic_int* stop;
+	int aborted;
+	int timeLogic;
+	unsigned long logicNanos;
+	MaskWord* logicScratch;
+} SudukuContext;
+
+/**
+ * @def struct SudukuBoard
+ * @brief the slots and occupancy bitmasks of a table - shared between a node and its children
+ */
+typedef struct SudukuBoard SudukuBoard;
+
+/**
+ * @def struct SudukuShape
+ * @brief the units of a table (rows, cols, sub squres or regions, diagonals and cages) - built
+ * 		once by createVariantTable and shared by all the boards of the table
+ */
+typedef struct SudukuShape SudukuShape;
+
 /**
  * @def struct Suduku
- * @brief each suduku define as struct that includes 3 params: the table size, amount of full slot
- * 		in the table and the table itself.
+ * @brief each suduku define as struct that includes the table size, the sub squre size, amount of
+ * 		full slot in the table and the board it lives on. Children of a node share the parent
+ * 		board and only keep the slot they fill (pendingSlot, -1 if none), the board is copied
+ * 		when the child itself is expanded - so a node costs a few bytes until it is used.
+ * 		context is the solve the node belongs to, NULL for plain search.
  */
 typedef struct Suduku
 {
 	int tableSize;
+	int boxSize;
 	int fullSlots;
-	int* table;
+	int maskWords;
+	SudukuBoard* board;
+	SudukuContext* context;
+	int pendingSlot;
+	Cell pendingVal;
 } Suduku;
 
 /**
@@ -34,10 +184,21 @@ typedef struct SlotIndex
  * @brief get all valid children of each node
  * @param void* suduku -  the suduku node
  * @param void*** optionalSolutions - pointer to array of children
- * @return the number of node children
+ * @return the number of node children, 0 if allocation failed (no child is made)
  */
 int getNodeChildren(void* suduku, void*** optionalSolutions);
 
+/**
+ * @def getNodeChildrenInto
+ * @brief same as getNodeChildren, but the children are written straight into the given buffer
+ * 		(one Suduku each), so no allocation is made for them
+ * @param void* suduku - the suduku node
+ * @param void* children - buffer of capacity Suduku nodes
+ * @param int capacity - the buffer size in nodes, at least the table size
+ * @return the number of node children, 0 if the buffer is too small
+ */
+int getNodeChildrenInto(void* suduku, void* children, int capacity);
+
 /**
  * @def getNodeVal
  * @brief get the value of given suduku table - it full slot amount.
@@ -46,6 +207,15 @@ int getNodeChildren(void* suduku, void*** optionalSolutions);
  */
 unsigned int getNodeVal(void* suduku);
 
+/**
+ * @def getNodeRank
+ * @brief rank the node for best first and beam search - its full slots first, then the candidates
+ * 		its pending value leaves to the empty slots around it (fewer eliminations rank higher)
+ * @param void* suduku - the suduku node
+ * @return the node rank, 0 if the pending value leaves a slot with no candidate
+ */
+unsigned long getNodeRank(void* suduku);
+
 /**
  * @def freeNode
  * @brief free from memory the suduku Node
@@ -53,6 +223,14 @@ unsigned int getNodeVal(void* suduku);
  */	
 void freeNode(void* suduku);
 
+/**
+ * @def clearNode
+ * @brief free from memory what the suduku Node holds, but not the node itself - so node that is 
+ * 		kept inline (see SearchOptions) can be released
+ * @param void* suduku- the suduku Node
+ */
+void clearNode(void* suduku);
+
 /**
  * @def copyNode
  * @brief A function that do deep copy of Node.
@@ -77,30 +255,94 @@ int findSqrt(const int size);
 void* createSudukuTable(const int tableSize);
 
 /**
- * @def check row
- * @brief check for validation in given slot row
- * @param Suduku* suduku - the suduku node with the table
- * @param SlotIndex* index - the index of the slot that need to check validation for
- * @param int* possibleValues - the array that represent the possible values 
+ * @def createVariantTable
+ * @brief creates an empty variant suduku table - all its units are turned into the same
+ * 		occupancy bitmasks the classic table uses, so the search runs the same code for both
+ * @param int tableSize - suduku table size, a square unless regions are given
+ * @param SudukuVariant* variant - the variant constraints, NULL for the classic table
+ * @return the suduku table, NULL if the constraints are not valid or allocation failed
  */
-void checkRow(Suduku* suduku, SlotIndex* index, int* PossibleValues);
+void* createVariantTable(const int tableSize, const SudukuVariant* variant);
 
 /**
- * @def check col
- * @brief check for validation in given slot col
+ * @def cloneNode
+ * @brief deep copy of the node with a board of its own (copyNode shares the board, so a copy
+ * 		made by copyNode can not be handed to another thread)
+ * @param Suduku* suduku - the node
+ * @return the copy, NULL if allocation failed
+ */
+Suduku* cloneNode(const Suduku* suduku);
+
+/**
+ * @def setSlotValue
+ * @brief put val in the given slot and update the row, col and sub squre occupancy bitmasks
  * @param Suduku* suduku - the suduku node with the table
- * @param SlotIndex* index - the index of the slot that need to check validation for
- * @param int* possibleValues - the array that represent the possible values 
+ * @param int tableIndex - the index of an empty slot in the table
+ * @param int val - the value to put in the slot (1..tableSize)
+ * @return False if val already appears in one of the slot units, or its cage sum can no longer
+ * 		be reached, otherwise True
  */
-void checkCol(Suduku* suduku, SlotIndex* index, int* PossibleValues);
+int setSlotValue(Suduku* suduku, int tableIndex, int val);
 
 /**
- * @def check sub Squre
- * @brief check for validation in given slot sub squre
+ * @def getSlotValue
+ * @brief get the value of the given slot
  * @param Suduku* suduku - the suduku node with the table
- * @param SlotIndex* index - the index of the slot that need to check validation for
- * @param int* possibleValues - the array that represent the possible values 
+ * @param int tableIndex - the index of the slot in the table
+ * @return the slot value, 0 for empty slot
+ */
+int getSlotValue(const Suduku* suduku, int tableIndex);
+
+/**
+ * @def getUnitAmount
+ * @brief the number of units of the table - rows are units 0..N-1, cols N..2N-1 and sub squres
+ * 		(or regions) 2N..3N-1, the diagonals and cages come after them
+ */
+int getUnitAmount(const Suduku* suduku);
+
+/**
+ * @def getUnitSlots
+ * @brief the slots of the given unit
+ * @param const int** slots - set to the slot indexes of the unit
+ * @return the number of slots in the unit
+ */
+int getUnitSlots(const Suduku* suduku, int unit, const int** slots);
+
+/**
+ * @def getUnitSum
+ * @brief the sum the values of the given unit add up to
+ * @return the cage sum, 0 if the unit has none
+ */
+int getUnitSum(const Suduku* suduku, int unit);
+
+/**
+ * @def getSlotUnits
+ * @brief the units the given slot belongs to
+ * @param const int** units - set to the unit indexes of the slot
+ * @return the number of units of the slot (at most MAX_SLOT_UNITS)
+ */
+int getSlotUnits(const Suduku* suduku, int tableIndex, const int** units);
+
+/**
+ * @def getSlotCandidates
+ * @brief the values that are still free for the given slot by its units and cage sum
+ * @param Suduku* suduku - the suduku node, with no pending slot (as in getNodeChildren)
+ * @param int tableIndex - the index of the slot in the table
+ * @param MaskWord* candidates - maskWords words that will hold the free values
+ * @return the number of free values
+ */
+int getSlotCandidates(const Suduku* suduku, int tableIndex, MaskWord* candidates);
+
+/**
+ * @def solveChoicePoints
+ * @brief solve the suduku in place with O(depth) memory: the only state besides the board is one
+ * 		choice point (slot, value tried) for each slot filled by the search, undone on backtrack.
+ * 		visits the same nodes in the same order as getBest over getNodeChildren.
+ * @param Suduku* suduku - the suduku node, filled with the solution when there is one
+ * @param size_t* peakMemory - set to the peak bytes the search used (board and the units it is
+ * 		checked against, node and choice points), may be NULL
+ * @return True if the suduku was solved otherwise False (no solution, or the context aborted)
  */
-void checksubSqure(Suduku* suduku, SlotIndex* index, int* PossibleValues);
+int solveChoicePoints(Suduku* suduku, size_t* peakMemory);
 
 #endif